@@ -0,0 +1,29 @@
+#!/bin/sh
+#
+# Masoara scalarea popularii eager (SO_LOADER_EAGER=1) cu numarul de
+# thread-uri, pe un program sintetic cu un segment de date mare.
+#
+# Utilizare: bench/eager_scaling.sh [dimensiune_MB] [thread-uri_max]
+# (se ruleaza din directorul Linux, dupa make && make -f Makefile.example)
+#
+
+SIZE_MB=${1:-512}
+MAX_THREADS=${2:-$(nproc)}
+PROG=./so_big_data
+
+export LD_LIBRARY_PATH=.${LD_LIBRARY_PATH:+:$LD_LIBRARY_PATH}
+
+gcc -m32 -nostdlib -no-pie -Wa,--defsym,DATA_SIZE=$((SIZE_MB << 20)) \
+	-o $PROG bench/big_data.S || exit 1
+
+# prima rulare aduce fisierul in page cache
+SO_LOADER_EAGER=1 ./so_exec $PROG
+
+threads=1
+while [ $threads -le "$MAX_THREADS" ]; do
+	SO_LOADER_STATS=1 SO_LOADER_EAGER=1 SO_LOADER_THREADS=$threads \
+		./so_exec $PROG 2>&1 | grep eager_pages
+	threads=$((threads * 2))
+done
+
+rm -f $PROG
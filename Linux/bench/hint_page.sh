@@ -0,0 +1,26 @@
+#!/bin/sh
+#
+# Compara numarul de page fault-uri ale programului test_prog/hints.S
+# fara si cu pagina de indicii: cu SO_LOADER_HINTS=1 programul cere
+# popularea tabelei inainte de a o parcurge.
+#
+# Utilizare: bench/hint_page.sh [dimensiune_MB]
+# (se ruleaza din directorul Linux, dupa make && make -f Makefile.example)
+#
+
+SIZE_MB=${1:-64}
+PROG=./so_hint_bench
+
+export LD_LIBRARY_PATH=.${LD_LIBRARY_PATH:+:$LD_LIBRARY_PATH}
+export SO_LOADER_STATS=1
+
+gcc -m32 -nostdlib -no-pie -Wa,--defsym,TABLE_SIZE=$((SIZE_MB << 20)) \
+	-o $PROG test_prog/hints.S || exit 1
+
+for hints in 0 1; do
+	echo "hints=$hints"
+	SO_LOADER_HINTS=$hints ./so_exec $PROG 2>&1 | \
+		grep 'hints \|no hint\|faults=\|hint_populated='
+done
+
+rm -f $PROG
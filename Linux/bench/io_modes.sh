@@ -0,0 +1,27 @@
+#!/bin/sh
+#
+# Compara latenta page fault-urilor intre modurile de citire read si mmap.
+#
+# Utilizare: bench/io_modes.sh <executabil> [repetari]
+# (se ruleaza din directorul Linux, dupa make && make -f Makefile.example)
+#
+
+PROG=${1:?"Utilizare: $0 <executabil> [repetari]"}
+RUNS=${2:-10}
+
+export LD_LIBRARY_PATH=.${LD_LIBRARY_PATH:+:$LD_LIBRARY_PATH}
+export SO_LOADER_STATS=1
+
+for mode in read mmap; do
+	i=0
+	while [ $i -lt "$RUNS" ]; do
+		SO_LOADER_IO=$mode ./so_exec "$PROG" 2>&1 >/dev/null |
+			sed -n 's/.*faults=\([0-9]*\) ns\/fault=\([0-9]*\).*/\1 \2/p'
+		i=$((i + 1))
+	done | awk -v mode=$mode '
+		{ faults += $1; ns += $1 * $2 }
+		END {
+			printf "%-4s faults/run=%d avg ns/fault=%d\n", mode,
+				faults / NR, faults ? ns / faults : 0
+		}'
+done
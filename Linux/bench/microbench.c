@@ -0,0 +1,202 @@
+/*
+ * Fault path microbenchmark
+ *
+ * 2018, Operating Systems
+ *
+ * Executa direct mecanismul de tratare a page fault-urilor al loader-ului,
+ * fara un program incarcat: pentru fiecare layout sintetic de segmente,
+ * atinge toate paginile (cate un SIGSEGV per pagina) si raporteaza ns/fault,
+ * impartit pe etape, cu page cache-ul cald si rece.
+ *
+ * Utilizare: make microbench (optiunile SO_LOADER_* se aplica normal)
+ */
+
+#define SO_PHASE_TIMING
+#include "loader.c"
+
+/* numarul de repetari; se raporteaza repetarea cea mai rapida */
+#define RUNS		5
+#define MAX_SEGMENTS	64
+#define FILE_SIZE	(64 << 20)
+
+struct layout {
+	const char *name;
+	int segments_no;
+	/* dimensiunile fiecarui segment */
+	unsigned int file_size;
+	unsigned int mem_size;
+	/* offset-ul din fisier al primului segment */
+	unsigned int offset;
+};
+
+static const struct layout layouts[] = {
+	/* multe segmente mici, cautarea segmentului conteaza */
+	{ "many_segments", MAX_SEGMENTS, 256 << 10, 256 << 10, 0 },
+	/* un segment cu 4KB de date si .bss mare */
+	{ "huge_bss", 1, 4 << 10, 128 << 20, 0 },
+	/* granite file_size/mem_size nealiniate la pagina */
+	{ "misaligned", 16, (1 << 20) + 1234, (2 << 20) + 777, 4096 },
+	/* un segment mare, doar date din fisier */
+	{ "file_backed", 1, 32 << 20, 32 << 20, 0 },
+};
+
+#define LAYOUTS_NO	(sizeof(layouts) / sizeof(layouts[0]))
+
+static const char * const phase_names[PHASES_NO] = {
+	"segment", "map", "zero", "read", "mprotect",
+};
+
+static so_seg_t segments[MAX_SEGMENTS];
+static so_exec_t bench_exec;
+
+/* aseaza segmentele layout-ului intr-o zona libera a spatiului de adrese */
+static void build_layout(const struct layout *l)
+{
+	size_t stride = ALIGN_UP(l->mem_size, (unsigned int)getpagesize()) +
+			getpagesize();
+	uintptr_t base;
+	void *area;
+	int i;
+
+	area = mmap(NULL, stride * l->segments_no, PROT_NONE,
+		    MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	DIE(area == MAP_FAILED, "mmap failed.");
+	munmap(area, stride * l->segments_no);
+	base = (uintptr_t)area;
+
+	memset(segments, 0, sizeof(segments));
+	for (i = 0; i < l->segments_no; i++) {
+		segments[i].vaddr = base + i * stride;
+		segments[i].file_size = l->file_size;
+		segments[i].mem_size = l->mem_size;
+		segments[i].offset = (l->offset + (size_t)i * l->file_size) %
+				     (FILE_SIZE - l->file_size) &
+				     ~(getpagesize() - 1);
+		segments[i].perm = i % 2 ? PERM_R | PERM_W : PERM_R;
+	}
+
+	bench_exec.segments_no = l->segments_no;
+	bench_exec.segments = segments;
+	exec = &bench_exec;
+	pages_no = compute_pages_no();
+	actions = actions_compile(exec, 0);
+}
+
+/* demapeaza segmentele si reseteaza starea paginilor */
+static void reset_layout(void)
+{
+	size_t size;
+	int i;
+
+	for (i = 0; i < exec->segments_no; i++) {
+		size = ALIGN_UP(exec->segments[i].mem_size,
+				(unsigned int)getpagesize());
+		munmap((void *)exec->segments[i].vaddr, size);
+		free(exec->segments[i].data);
+		exec->segments[i].data = NULL;
+	}
+}
+
+/* atinge fiecare pagina; intoarce numarul de page fault-uri */
+static uint64_t touch_pages(void)
+{
+	volatile char *p;
+	uint64_t faults = 0;
+	unsigned int j;
+	int i;
+
+	for (i = 0; i < exec->segments_no; i++) {
+		for (j = 0; j < pages_no[i]; j++) {
+			p = (char *)exec->segments[i].vaddr +
+			    j * getpagesize();
+			(void)*p;
+			faults++;
+		}
+	}
+
+	return faults;
+}
+
+static void run_layout(const struct layout *l, int cold)
+{
+	uint64_t best_phases[PHASES_NO], best = ~0ull, start, total, faults;
+	uint64_t other;
+	int run, i;
+
+	build_layout(l);
+
+	for (run = 0; run < RUNS; run++) {
+		if (cold)
+			posix_fadvise(source->fd, 0, 0, POSIX_FADV_DONTNEED);
+
+		if (so_cfg.reserve)
+			reserve_segments();
+
+		memset(phase_ns, 0, sizeof(phase_ns));
+		start = stats_now();
+		faults = touch_pages();
+		total = stats_now() - start;
+
+		if (total < best) {
+			best = total;
+			memcpy(best_phases, phase_ns, sizeof(phase_ns));
+		}
+
+		reset_layout();
+	}
+
+	printf("%-14s %-4s faults=%-6llu ns/fault=%-6llu",
+	       l->name, cold ? "cold" : "warm", (unsigned long long)faults,
+	       (unsigned long long)(best / faults));
+	/* restul: livrarea semnalului, intrarea si iesirea din handler */
+	other = best;
+	for (i = 0; i < PHASES_NO; i++) {
+		printf(" %s=%llu", phase_names[i],
+		       (unsigned long long)(best_phases[i] / faults));
+		other -= best_phases[i];
+	}
+	printf(" other=%llu\n", (unsigned long long)(other / faults));
+
+	for (i = 0; i < exec->segments_no; i++)
+		free(actions[i].entries);
+	free(actions);
+	free(pages_no);
+}
+
+int main(void)
+{
+	char path[] = "/tmp/so_microbenchXXXXXX";
+	static char buf[1 << 20];
+	unsigned int i;
+	int fd, cold;
+
+	/* fisierul din care sunt citite datele segmentelor */
+	fd = mkstemp(path);
+	DIE(fd < 0, "mkstemp failed.");
+	for (i = 0; i < sizeof(buf); i++)
+		buf[i] = i * 31 + 7;
+	for (i = 0; i < FILE_SIZE / sizeof(buf); i++)
+		DIE(write(fd, buf, sizeof(buf)) != sizeof(buf),
+		    "write failed.");
+	close(fd);
+
+	so_init_loader();
+	source = source_open(path);
+	DIE(!source, "source_open failed.");
+	if (so_cfg.io_mode == IO_MMAP && source_map(source, &bench_exec) < 0)
+		so_cfg.io_mode = IO_READ;
+	if (so_cfg.pool)
+		pool_init(so_cfg.pool);
+
+	printf("io=%s reserve=%d simd=%s pool=%d\n",
+	       so_cfg.io_mode == IO_MMAP ? "mmap" : "read", so_cfg.reserve,
+	       so_page_ops.name, so_cfg.pool);
+
+	for (i = 0; i < LAYOUTS_NO; i++)
+		for (cold = 0; cold < 2; cold++)
+			run_layout(&layouts[i], cold);
+
+	unlink(path);
+
+	return 0;
+}
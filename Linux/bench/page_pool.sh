@@ -0,0 +1,24 @@
+#!/bin/sh
+#
+# Compara latenta page fault-urilor fara pool si cu pool-uri de pagini
+# pre-zeroizate de diferite dimensiuni, pe un program sintetic mare.
+#
+# Utilizare: bench/page_pool.sh [dimensiune_MB]
+# (se ruleaza din directorul Linux, dupa make && make -f Makefile.example)
+#
+
+SIZE_MB=${1:-256}
+PROG=./so_big_data
+
+export LD_LIBRARY_PATH=.${LD_LIBRARY_PATH:+:$LD_LIBRARY_PATH}
+export SO_LOADER_STATS=1
+
+gcc -m32 -nostdlib -no-pie -Wa,--defsym,DATA_SIZE=$((SIZE_MB << 20)) \
+	-o $PROG bench/big_data.S || exit 1
+
+for pool in 0 64 1024 8192; do
+	echo "pool=$pool"
+	SO_LOADER_POOL=$pool ./so_exec $PROG 2>&1 | grep 'reserve=\|pool='
+done
+
+rm -f $PROG
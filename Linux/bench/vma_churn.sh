@@ -0,0 +1,24 @@
+#!/bin/sh
+#
+# Compara numarul de VMA-uri si latenta page fault-urilor intre maparea
+# fiecarei pagini cu mmap (SO_LOADER_RESERVE=0) si modelul cu rezervarea
+# zonelor segmentelor (implicit), pe un program sintetic mare.
+#
+# Utilizare: bench/vma_churn.sh [dimensiune_MB]
+# (se ruleaza din directorul Linux, dupa make && make -f Makefile.example)
+#
+
+SIZE_MB=${1:-256}
+PROG=./so_big_data
+
+export LD_LIBRARY_PATH=.${LD_LIBRARY_PATH:+:$LD_LIBRARY_PATH}
+export SO_LOADER_STATS=1
+
+gcc -m32 -nostdlib -no-pie -Wa,--defsym,DATA_SIZE=$((SIZE_MB << 20)) \
+	-o $PROG bench/big_data.S || exit 1
+
+for reserve in 0 1; do
+	SO_LOADER_RESERVE=$reserve ./so_exec $PROG 2>&1 | grep reserve=
+done
+
+rm -f $PROG
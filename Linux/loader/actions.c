@@ -0,0 +1,69 @@
+/*
+ * Precompiled per-page fault actions
+ *
+ * 2018, Operating Systems
+ */
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "actions.h"
+#include "zero_index.h"
+#include "utils.h"
+
+/* PERM_* au aceleasi valori ca PROT_* */
+static uint8_t perm_to_prot(unsigned int perm)
+{
+	return (perm & PERM_R ? PROT_READ : 0) |
+	       (perm & PERM_W ? PROT_WRITE : 0) |
+	       (perm & PERM_X ? PROT_EXEC : 0);
+}
+
+static void compile_segment(so_exec_t *exec, int seg_index,
+			    struct action_table *table, int use_zero_index)
+{
+	so_seg_t *segment = &exec->segments[seg_index];
+	unsigned int page_size = getpagesize();
+	struct page_action *act;
+	unsigned int i, start;
+
+	table->prot = perm_to_prot(segment->perm);
+	table->pages = ALIGN_UP(segment->file_size, page_size) / page_size;
+	if (!table->pages)
+		return;
+
+	table->entries = malloc(table->pages * sizeof(*table->entries));
+	DIE(!table->entries, "malloc failed.");
+
+	for (i = 0; i < table->pages; i++) {
+		act = &table->entries[i];
+		start = i * page_size;
+
+		act->offset = segment->offset + start;
+		act->prot = table->prot;
+		act->len = 0;
+		if (use_zero_index && zero_index_test(seg_index, i)) {
+			act->kind = ACTION_FILE_ZERO;
+		} else if (segment->file_size - start >= page_size) {
+			act->kind = ACTION_COPY;
+		} else {
+			act->kind = ACTION_COPY_ZERO;
+			act->len = segment->file_size - start;
+		}
+	}
+}
+
+struct action_table *actions_compile(so_exec_t *exec, int use_zero_index)
+{
+	struct action_table *tables;
+	int i;
+
+	tables = calloc(exec->segments_no, sizeof(*tables));
+	DIE(!tables, "calloc failed.");
+
+	for (i = 0; i < exec->segments_no; i++)
+		compile_segment(exec, i, &tables[i], use_zero_index);
+
+	return tables;
+}
@@ -0,0 +1,61 @@
+/*
+ * Precompiled per-page fault actions
+ *
+ * 2018, Operating Systems
+ */
+
+#ifndef SO_ACTIONS_H_
+#define SO_ACTIONS_H_
+
+#include <stdint.h>
+
+#include "exec_parser.h"
+
+/* ce trebuie facut la primul acces al unei pagini */
+enum page_action_kind {
+	/* pagina contine doar zerouri (.bss): doar se aloca */
+	ACTION_ZERO,
+	/* pagina din fisier cu date doar zero (indexul de zerouri) */
+	ACTION_FILE_ZERO,
+	/* pagina este copiata integral din fisier */
+	ACTION_COPY,
+	/* primii len bytes sunt copiati, restul paginii este zeroizat */
+	ACTION_COPY_ZERO,
+};
+
+/* o intrare de 8 bytes, pentru ca tabelele mari sa ramana compacte */
+struct page_action {
+	/* offset-ul datelor in fisier */
+	uint32_t offset;
+	/* numarul de bytes copiati (ACTION_COPY_ZERO) */
+	uint16_t len;
+	uint8_t kind;
+	/* permisiunile finale (PROT_*) */
+	uint8_t prot;
+};
+
+/*
+ * tabela unui segment; contine doar paginile pana la sfarsitul datelor din
+ * fisier, paginile de dupa (.bss) sunt implicit ACTION_ZERO
+ */
+struct action_table {
+	struct page_action *entries;
+	unsigned int pages;
+	uint8_t prot;
+};
+
+/*
+ * compileaza tabela fiecarui segment; paginile marcate de indexul de
+ * zerouri devin ACTION_FILE_ZERO daca use_zero_index este nenul
+ */
+struct action_table *actions_compile(so_exec_t *exec, int use_zero_index);
+
+static inline struct page_action action_lookup(const struct action_table *t,
+					       unsigned int page)
+{
+	struct page_action bss = { 0, 0, ACTION_ZERO, t->prot };
+
+	return page < t->pages ? t->entries[page] : bss;
+}
+
+#endif /* SO_ACTIONS_H_ */
@@ -0,0 +1,171 @@
+/*
+ * Content-addressed chunk store
+ *
+ * 2018, Operating Systems
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+
+#include "chunk_store.h"
+
+/* constantele rundelor SHA-256 (FIPS 180-4) */
+static const uint32_t K[64] = {
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1,
+	0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+	0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786,
+	0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+	0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+	0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+	0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a,
+	0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+	0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+static inline uint32_t rotr32(uint32_t x, int r)
+{
+	return (x >> r) | (x << (32 - r));
+}
+
+/* proceseaza un bloc de 64 de bytes */
+static void sha256_block(uint32_t state[8], const uint8_t *block)
+{
+	uint32_t w[64], t1, t2;
+	uint32_t a, b, c, d, e, f, g, h;
+	int i;
+
+	for (i = 0; i < 16; i++)
+		w[i] = (uint32_t)block[4 * i] << 24 |
+		       (uint32_t)block[4 * i + 1] << 16 |
+		       (uint32_t)block[4 * i + 2] << 8 |
+		       (uint32_t)block[4 * i + 3];
+	for (i = 16; i < 64; i++)
+		w[i] = w[i - 16] + w[i - 7] +
+		       (rotr32(w[i - 15], 7) ^ rotr32(w[i - 15], 18) ^
+			(w[i - 15] >> 3)) +
+		       (rotr32(w[i - 2], 17) ^ rotr32(w[i - 2], 19) ^
+			(w[i - 2] >> 10));
+
+	a = state[0];
+	b = state[1];
+	c = state[2];
+	d = state[3];
+	e = state[4];
+	f = state[5];
+	g = state[6];
+	h = state[7];
+
+	for (i = 0; i < 64; i++) {
+		t1 = h + (rotr32(e, 6) ^ rotr32(e, 11) ^ rotr32(e, 25)) +
+		     ((e & f) ^ (~e & g)) + K[i] + w[i];
+		t2 = (rotr32(a, 2) ^ rotr32(a, 13) ^ rotr32(a, 22)) +
+		     ((a & b) ^ (a & c) ^ (b & c));
+		h = g;
+		g = f;
+		f = e;
+		e = d + t1;
+		d = c;
+		c = b;
+		b = a;
+		a = t1 + t2;
+	}
+
+	state[0] += a;
+	state[1] += b;
+	state[2] += c;
+	state[3] += d;
+	state[4] += e;
+	state[5] += f;
+	state[6] += g;
+	state[7] += h;
+}
+
+void chunk_hash(const void *buf, size_t len, struct chunk_id *id)
+{
+	uint32_t state[8] = {
+		0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+		0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+	};
+	const uint8_t *data = buf;
+	uint64_t bits = (uint64_t)len * 8;
+	uint8_t tail[128];
+	size_t i, rest;
+
+	for (i = 0; i + 64 <= len; i += 64)
+		sha256_block(state, data + i);
+
+	/* ultimul bloc (sau ultimele doua): 0x80, zerouri, lungimea in biti */
+	rest = len - i;
+	memset(tail, 0, sizeof(tail));
+	memcpy(tail, data + i, rest);
+	tail[rest] = 0x80;
+	rest = rest < 56 ? 64 : 128;
+	for (i = 0; i < 8; i++)
+		tail[rest - 1 - i] = bits >> (8 * i);
+	sha256_block(state, tail);
+	if (rest == 128)
+		sha256_block(state, tail + 64);
+
+	for (i = 0; i < 8; i++) {
+		id->digest[4 * i] = state[i] >> 24;
+		id->digest[4 * i + 1] = state[i] >> 16;
+		id->digest[4 * i + 2] = state[i] >> 8;
+		id->digest[4 * i + 3] = state[i];
+	}
+}
+
+void chunk_path(const char *store, const struct chunk_id *id, char *path,
+		size_t size)
+{
+	char hex[2 * sizeof(id->digest) + 1];
+	size_t i;
+
+	for (i = 0; i < sizeof(id->digest); i++)
+		sprintf(hex + 2 * i, "%02x", id->digest[i]);
+
+	snprintf(path, size, "%s/%.2s/%s", store, hex, hex);
+}
+
+int chunk_store_put(const char *store, const struct chunk_id *id,
+		    const void *buf, size_t len)
+{
+	/* numele temporare sunt unice si intre thread-uri */
+	static unsigned int seq;
+	char path[4096], tmp[4096 + 32];
+	char *slash;
+	ssize_t ret;
+	int fd;
+
+	chunk_path(store, id, path, sizeof(path));
+	if (access(path, F_OK) == 0)
+		return 0;
+
+	/* directorul <store>/<xx> */
+	slash = strrchr(path, '/');
+	*slash = '\0';
+	if (mkdir(path, 0755) < 0 && errno != EEXIST)
+		return -1;
+	*slash = '/';
+
+	snprintf(tmp, sizeof(tmp), "%s.tmp.%d.%u", path, (int)getpid(),
+		 __atomic_fetch_add(&seq, 1, __ATOMIC_RELAXED));
+	fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0444);
+	if (fd < 0)
+		return -1;
+
+	ret = write(fd, buf, len);
+	close(fd);
+	if (ret != (ssize_t)len || rename(tmp, path) < 0) {
+		unlink(tmp);
+		return -1;
+	}
+
+	return 1;
+}
@@ -0,0 +1,52 @@
+/*
+ * Content-addressed chunk store
+ *
+ * 2018, Operating Systems
+ */
+
+#ifndef SO_CHUNK_STORE_H_
+#define SO_CHUNK_STORE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define CHUNK_RECIPE_MAGIC	0x52434f53	/* "SOCR" */
+#define CHUNK_RECIPE_VERSION	2
+
+/*
+ * un executabil din store este descris de o reteta: antetul, urmat de
+ * identificatorii (digest-urile SHA-256) celor chunks_no bucati de
+ * chunk_size bytes ale fisierului (ultima poate fi mai scurta)
+ */
+struct chunk_recipe_hdr {
+	uint32_t magic;
+	uint16_t version;
+	uint16_t hdr_size;
+	uint32_t chunk_size;
+	uint32_t chunks_no;
+	uint64_t file_size;
+};
+
+struct chunk_id {
+	uint8_t digest[32];
+};
+
+/*
+ * digest-ul SHA-256 al continutului unei bucati; fiind criptografic, nu
+ * se pot construi bucati diferite cu acelasi identificator, deci o bucata
+ * adusa din origine si verificata nu poate inlocui alta in store
+ */
+void chunk_hash(const void *buf, size_t len, struct chunk_id *id);
+
+/* calea bucatii in store: <store>/<2 cifre hex>/<64 cifre hex> */
+void chunk_path(const char *store, const struct chunk_id *id, char *path,
+		size_t size);
+
+/*
+ * adauga bucata in store (atomic, prin redenumire) daca nu exista deja;
+ * intoarce 1 daca a fost adaugata, 0 daca exista deja sau -1 la eroare
+ */
+int chunk_store_put(const char *store, const struct chunk_id *id,
+		    const void *buf, size_t len);
+
+#endif /* SO_CHUNK_STORE_H_ */
@@ -0,0 +1,81 @@
+/*
+ * Loader configuration
+ *
+ * 2018, Operating Systems
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "config.h"
+
+struct so_config so_cfg;
+
+/* intoarce valoarea variabilei de mediu sau NULL daca este vida */
+static const char *env_str(const char *name)
+{
+	const char *value = getenv(name);
+
+	if (!value || !*value)
+		return NULL;
+
+	return value;
+}
+
+/* intoarce valoarea numerica a variabilei de mediu sau def */
+static long env_long(const char *name, long def)
+{
+	const char *value = env_str(name);
+
+	return value ? strtol(value, NULL, 0) : def;
+}
+
+void config_init(void)
+{
+	const char *value;
+
+	so_cfg.cache_dir = env_str("SO_LOADER_CACHE_DIR");
+
+	value = env_str("SO_LOADER_IO");
+	so_cfg.io_mode = value && !strcmp(value, "mmap") ? IO_MMAP : IO_READ;
+
+	so_cfg.reserve = env_long("SO_LOADER_RESERVE", 1);
+	so_cfg.simd = env_str("SO_LOADER_SIMD");
+	so_cfg.stats = env_long("SO_LOADER_STATS", 0);
+	so_cfg.numa = env_str("SO_LOADER_NUMA");
+	so_cfg.prefault = env_long("SO_LOADER_PREFAULT", 0);
+	so_cfg.manifest = env_str("SO_LOADER_MANIFEST");
+	so_cfg.zero_index = env_long("SO_LOADER_ZERO_INDEX", 0);
+	so_cfg.eager = env_long("SO_LOADER_EAGER", 0);
+	so_cfg.threads = env_long("SO_LOADER_THREADS",
+				  sysconf(_SC_NPROCESSORS_ONLN));
+	if (so_cfg.threads < 1)
+		so_cfg.threads = 1;
+	so_cfg.perf_map = env_long("SO_LOADER_PERF_MAP", 0);
+	so_cfg.gdb_jit = env_long("SO_LOADER_GDB_JIT", 0);
+	so_cfg.trace = env_str("SO_LOADER_TRACE");
+	so_cfg.fault_around = env_long("SO_LOADER_FAULT_AROUND", 1);
+	if (so_cfg.fault_around < 1)
+		so_cfg.fault_around = 1;
+	so_cfg.autotune = env_long("SO_LOADER_AUTOTUNE", 0);
+	so_cfg.pool = env_long("SO_LOADER_POOL", 0);
+	if (so_cfg.pool < 0)
+		so_cfg.pool = 0;
+	so_cfg.chunk_store = env_str("SO_LOADER_CHUNK_STORE");
+	so_cfg.chunk_origin = env_str("SO_LOADER_CHUNK_ORIGIN");
+	so_cfg.perf = env_long("SO_LOADER_PERF", 0);
+	so_cfg.footprint = env_long("SO_LOADER_FOOTPRINT", 0);
+	if (so_cfg.footprint < 0)
+		so_cfg.footprint = 0;
+	so_cfg.pipeline = env_long("SO_LOADER_PIPELINE", 0);
+	so_cfg.hints = env_long("SO_LOADER_HINTS", 0);
+	so_cfg.kernel_populate = env_long("SO_LOADER_KERNEL_POPULATE", 1);
+	if (so_cfg.perf)
+		so_cfg.stats = 1;
+}
+
+int config_is_set(const char *name)
+{
+	return env_str(name) != NULL;
+}
@@ -0,0 +1,142 @@
+/*
+ * Loader configuration
+ *
+ * 2018, Operating Systems
+ */
+
+#ifndef SO_CONFIG_H_
+#define SO_CONFIG_H_
+
+/* modul in care sunt citite datele paginilor din executabil */
+enum so_io_mode {
+	/* un pread pentru fiecare pagina */
+	IO_READ,
+	/* executabilul este mapat o singura data, paginile sunt copiate */
+	IO_MMAP,
+};
+
+/*
+ * optiunile loader-ului; sunt citite o singura data, din variabilele de
+ * mediu SO_LOADER_*, in momentul initializarii loader-ului
+ */
+struct so_config {
+	/*
+	 * directorul in care se pastreaza planurile de incarcare
+	 * (SO_LOADER_CACHE_DIR); NULL daca cache-ul este dezactivat
+	 */
+	const char *cache_dir;
+	/* SO_LOADER_IO=read|mmap */
+	enum so_io_mode io_mode;
+	/*
+	 * SO_LOADER_RESERVE=0 -> dezactiveaza rezervarea zonelor segmentelor
+	 * in so_execute (fiecare pagina este mapata separat, cu mmap)
+	 */
+	int reserve;
+	/*
+	 * SO_LOADER_SIMD=generic|sse2|avx2|avx512 -> forteaza varianta
+	 * rutinelor de copiere/zeroizare (implicit, aleasa dupa CPUID)
+	 */
+	const char *simd;
+	/* SO_LOADER_STATS=1 -> se afiseaza statisticile la final */
+	int stats;
+	/*
+	 * SO_LOADER_NUMA=[segment=]politica;... -> politica de plasare NUMA
+	 * a paginilor (local, interleave[:noduri], bind:noduri)
+	 */
+	const char *numa;
+	/*
+	 * SO_LOADER_PREFAULT=1 -> paginile de cod atinse la pornire (analiza
+	 * statica de la entry point) sunt mapate inainte de salt
+	 */
+	int prefault;
+	/*
+	 * SO_LOADER_MANIFEST=<fisier> -> manifestul cu digest-urile paginilor;
+	 * fiecare pagina citita din executabil este verificata inainte de a
+	 * fi mapata
+	 */
+	const char *manifest;
+	/*
+	 * SO_LOADER_ZERO_INDEX=1 -> paginile din fisier care contin doar
+	 * zerouri sunt indexate in so_execute si nu mai sunt citite
+	 */
+	int zero_index;
+	/*
+	 * SO_LOADER_EAGER=1 -> toate segmentele sunt populate in so_execute,
+	 * in paralel, de SO_LOADER_THREADS thread-uri (implicit numarul de
+	 * procesoare)
+	 */
+	int eager;
+	int threads;
+	/* SO_LOADER_PERF_MAP=1 -> se scrie /tmp/perf-<pid>.map */
+	int perf_map;
+	/* SO_LOADER_GDB_JIT=1 -> executabilul este inregistrat in GDB */
+	int gdb_jit;
+	/*
+	 * SO_LOADER_TRACE=<fisier> -> se inregistreaza adresa si momentul
+	 * fiecarui page fault (folosit de so_pack si so_faultsim)
+	 */
+	const char *trace;
+	/*
+	 * SO_LOADER_FAULT_AROUND=<n> -> la un page fault sunt mapate n pagini
+	 * consecutive ale segmentului (implicit 1, doar pagina accesata)
+	 */
+	int fault_around;
+	/*
+	 * SO_LOADER_AUTOTUNE=<n> -> programul este rulat de n ori cu fiecare
+	 * configuratie candidat, iar cea mai rapida este salvata in cache
+	 */
+	int autotune;
+	/*
+	 * SO_LOADER_POOL=<n> -> pool de n pagini pre-alocate si zeroizate de
+	 * un thread de fundal, mutate cu mremap la adresa paginii accesate
+	 */
+	int pool;
+	/*
+	 * SO_LOADER_CHUNK_STORE=<dir> -> store-ul din care sunt citite
+	 * executabilele chunks:<reteta>; SO_LOADER_CHUNK_ORIGIN=<sursa> ->
+	 * de unde sunt aduse (si adaugate in store) bucatile lipsa
+	 */
+	const char *chunk_store;
+	const char *chunk_origin;
+	/*
+	 * SO_LOADER_PERF=1 -> contoare perf_event_open (cicluri, instructiuni,
+	 * TLB, page fault-uri, schimbari de context) pentru executia
+	 * programului, raportate impreuna cu statisticile (implica
+	 * SO_LOADER_STATS=1)
+	 */
+	int perf;
+	/*
+	 * SO_LOADER_FOOTPRINT=<ms> -> la fiecare ms milisecunde se afiseaza
+	 * footprint-ul fiecarui segment (pagini rezidente, scrise, partajate,
+	 * pagina zero, swap, pagini mapate in avans si neaccesate)
+	 */
+	int footprint;
+	/*
+	 * SO_LOADER_PIPELINE=1 -> antetul, pagina entry point-ului si prima
+	 * pagina de date sunt aduse de un thread pornit imediat dupa
+	 * deschiderea executabilului, in paralel cu restul pregatirilor din
+	 * so_execute
+	 */
+	int pipeline;
+	/*
+	 * SO_LOADER_HINTS=1 -> programul primeste (in auxv) adresa unei
+	 * pagini prin care poate cere popularea sau eliberarea unor zone
+	 */
+	int hints;
+	/*
+	 * SO_LOADER_KERNEL_POPULATE=0 -> paginile mapate in avans sunt
+	 * completate doar in user space (implicit, paginile copiate integral
+	 * din executabil sunt mapate direct din fisier si populate de kernel)
+	 */
+	int kernel_populate;
+};
+
+extern struct so_config so_cfg;
+
+/* citeste configuratia din mediu */
+void config_init(void);
+
+/* intoarce 1 daca optiunea name a fost setata explicit in mediu */
+int config_is_set(const char *name);
+
+#endif /* SO_CONFIG_H_ */
@@ -0,0 +1,68 @@
+/*
+ * CRC32C (Castagnoli) checksum
+ *
+ * 2018, Operating Systems
+ */
+
+#include <string.h>
+
+#include "crc32c.h"
+
+/* polinomul Castagnoli (reflectat) */
+#define CRC32C_POLY	0x82f63b78
+
+static uint32_t table[256];
+
+static uint32_t (*crc32c_impl)(uint32_t crc, const unsigned char *p,
+			       size_t len);
+
+static uint32_t crc32c_sw(uint32_t crc, const unsigned char *p, size_t len)
+{
+	while (len--)
+		crc = table[(crc ^ *p++) & 0xff] ^ (crc >> 8);
+
+	return crc;
+}
+
+#if defined(__i386__) || defined(__x86_64__)
+__attribute__((target("sse4.2")))
+static uint32_t crc32c_sse42(uint32_t crc, const unsigned char *p,
+			     size_t len)
+{
+	uint32_t word;
+
+	for (; len >= sizeof(word); len -= sizeof(word), p += sizeof(word)) {
+		memcpy(&word, p, sizeof(word));
+		crc = __builtin_ia32_crc32si(crc, word);
+	}
+	while (len--)
+		crc = __builtin_ia32_crc32qi(crc, *p++);
+
+	return crc;
+}
+#endif
+
+void crc32c_init(void)
+{
+	uint32_t crc;
+	int i, j;
+
+	for (i = 0; i < 256; i++) {
+		crc = i;
+		for (j = 0; j < 8; j++)
+			crc = crc & 1 ? (crc >> 1) ^ CRC32C_POLY : crc >> 1;
+		table[i] = crc;
+	}
+
+	crc32c_impl = crc32c_sw;
+#if defined(__i386__) || defined(__x86_64__)
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("sse4.2"))
+		crc32c_impl = crc32c_sse42;
+#endif
+}
+
+uint32_t crc32c(const void *buf, size_t len)
+{
+	return ~crc32c_impl(~0u, buf, len);
+}
@@ -0,0 +1,22 @@
+/*
+ * CRC32C (Castagnoli) checksum
+ *
+ * 2018, Operating Systems
+ */
+
+#ifndef SO_CRC32C_H_
+#define SO_CRC32C_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * alege implementarea (SSE4.2, daca procesorul o suporta, altfel cea
+ * software); trebuie apelata inainte de crc32c
+ */
+void crc32c_init(void);
+
+/* calculeaza CRC32C pentru len bytes de la buf */
+uint32_t crc32c(const void *buf, size_t len);
+
+#endif /* SO_CRC32C_H_ */
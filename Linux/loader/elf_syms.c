@@ -0,0 +1,155 @@
+/*
+ * ELF symbol table reader
+ *
+ * 2018, Operating Systems
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <elf.h>
+
+#include "elf_syms.h"
+
+/* citeste exact len bytes de la offset; intoarce 0 sau -1 */
+static int pread_all(int fd, void *buf, size_t len, off_t offset)
+{
+	char *p = buf;
+	ssize_t ret;
+
+	while (len > 0) {
+		ret = pread(fd, p, len, offset);
+		if (ret <= 0)
+			return -1;
+		p += ret;
+		len -= ret;
+		offset += ret;
+	}
+
+	return 0;
+}
+
+/* aloca si citeste o zona din fisier */
+static void *read_at(int fd, size_t len, off_t offset)
+{
+	void *buf = malloc(len ? len : 1);
+
+	if (buf && pread_all(fd, buf, len, offset) < 0) {
+		free(buf);
+		return NULL;
+	}
+
+	return buf;
+}
+
+static int cmp_sym(const void *a, const void *b)
+{
+	const struct elf_sym *sa = a, *sb = b;
+
+	if (sa->addr != sb->addr)
+		return sa->addr < sb->addr ? -1 : 1;
+	return 0;
+}
+
+/* intoarce indexul primei sectiuni de tipul type sau -1 */
+static int find_section(Elf32_Shdr *shdr, int shnum, uint32_t type)
+{
+	int i;
+
+	for (i = 0; i < shnum; i++)
+		if (shdr[i].sh_type == type)
+			return i;
+
+	return -1;
+}
+
+int elf_syms_read(int fd, struct elf_syms *syms)
+{
+	Elf32_Ehdr ehdr;
+	Elf32_Shdr *shdr = NULL, *symsec, *strsec;
+	Elf32_Sym *sym = NULL;
+	int i, idx, nsyms;
+
+	memset(syms, 0, sizeof(*syms));
+
+	if (pread_all(fd, &ehdr, sizeof(ehdr), 0) < 0 ||
+	    !ehdr.e_shoff || !ehdr.e_shnum ||
+	    ehdr.e_shentsize != sizeof(Elf32_Shdr))
+		return -1;
+
+	shdr = read_at(fd, ehdr.e_shnum * sizeof(Elf32_Shdr), ehdr.e_shoff);
+	if (!shdr)
+		return -1;
+
+	idx = find_section(shdr, ehdr.e_shnum, SHT_SYMTAB);
+	if (idx < 0)
+		idx = find_section(shdr, ehdr.e_shnum, SHT_DYNSYM);
+	if (idx < 0)
+		goto out_err;
+
+	symsec = &shdr[idx];
+	if (symsec->sh_link >= ehdr.e_shnum ||
+	    symsec->sh_entsize != sizeof(Elf32_Sym))
+		goto out_err;
+	strsec = &shdr[symsec->sh_link];
+
+	nsyms = symsec->sh_size / sizeof(Elf32_Sym);
+	sym = read_at(fd, symsec->sh_size, symsec->sh_offset);
+	/* terminatorul garanteaza ca toate numele sunt string-uri valide */
+	syms->strtab = calloc(1, strsec->sh_size + 1);
+	syms->syms = malloc(nsyms * sizeof(struct elf_sym) + 1);
+	if (!sym || !syms->strtab || !syms->syms ||
+	    pread_all(fd, syms->strtab, strsec->sh_size,
+		      strsec->sh_offset) < 0)
+		goto out_err;
+
+	for (i = 0; i < nsyms; i++) {
+		if (ELF32_ST_TYPE(sym[i].st_info) != STT_FUNC ||
+		    sym[i].st_shndx == SHN_UNDEF || !sym[i].st_value ||
+		    sym[i].st_name >= strsec->sh_size)
+			continue;
+
+		syms->syms[syms->count].addr = sym[i].st_value;
+		syms->syms[syms->count].size = sym[i].st_size;
+		syms->syms[syms->count].name = syms->strtab + sym[i].st_name;
+		syms->count++;
+	}
+
+	qsort(syms->syms, syms->count, sizeof(struct elf_sym), cmp_sym);
+
+	free(sym);
+	free(shdr);
+	return 0;
+
+out_err:
+	free(sym);
+	free(shdr);
+	elf_syms_free(syms);
+	return -1;
+}
+
+void elf_syms_free(struct elf_syms *syms)
+{
+	free(syms->syms);
+	free(syms->strtab);
+	memset(syms, 0, sizeof(*syms));
+}
+
+struct elf_sym *elf_syms_find(struct elf_syms *syms, uintptr_t addr)
+{
+	int start = 0, end = syms->count - 1, mid;
+
+	/* ultimul simbol cu adresa <= addr */
+	while (start <= end) {
+		mid = start + (end - start) / 2;
+		if (syms->syms[mid].addr <= addr)
+			start = mid + 1;
+		else
+			end = mid - 1;
+	}
+
+	if (end < 0 || addr >= syms->syms[end].addr + syms->syms[end].size)
+		return NULL;
+
+	return &syms->syms[end];
+}
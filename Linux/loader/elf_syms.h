@@ -0,0 +1,40 @@
+/*
+ * ELF symbol table reader
+ *
+ * 2018, Operating Systems
+ */
+
+#ifndef SO_ELF_SYMS_H_
+#define SO_ELF_SYMS_H_
+
+#include <stdint.h>
+
+/* un simbol de tip functie al executabilului */
+struct elf_sym {
+	uintptr_t addr;
+	unsigned int size;
+	const char *name;
+};
+
+/* simbolurile de tip functie, sortate dupa adresa */
+struct elf_syms {
+	struct elf_sym *syms;
+	int count;
+	/* tabela de string-uri in care pointeaza numele simbolurilor */
+	char *strtab;
+};
+
+/*
+ * citeste simbolurile de tip functie din .symtab (sau din .dynsym, daca
+ * .symtab lipseste) folosind pread pe fd, fara a accesa paginile
+ * executabilului din memorie; intoarce 0 sau -1 daca nu exista simboluri
+ */
+int elf_syms_read(int fd, struct elf_syms *syms);
+
+/* elibereaza simbolurile citite de elf_syms_read */
+void elf_syms_free(struct elf_syms *syms);
+
+/* intoarce simbolul care contine adresa addr sau NULL */
+struct elf_sym *elf_syms_find(struct elf_syms *syms, uintptr_t addr);
+
+#endif /* SO_ELF_SYMS_H_ */
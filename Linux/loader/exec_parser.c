@@ -14,7 +14,21 @@
 
 #include "exec_parser.h"
 
-#define BUFSIZE 1024
+#define BUFSIZE EXEC_HDR_SIZE
+
+static uintptr_t hint_page;
+
+void so_set_hint_page(uintptr_t addr)
+{
+	hint_page = addr;
+}
+
+static void (*before_jump)(void);
+
+void so_set_before_jump(void (*fn)(void))
+{
+	before_jump = fn;
+}
 
 static void fix_auxv(uintptr_t base, char *envp[])
 {
@@ -45,7 +59,12 @@ static void fix_auxv(uintptr_t base, char *envp[])
 			auxv->a_un.a_val = ehdr->e_entry;
 			break;
 		case AT_EXECFN:
-			auxv->a_un.a_val = 0;
+			if (hint_page) {
+				auxv->a_type = AT_SO_HINT;
+				auxv->a_un.a_val = (uint32_t)hint_page;
+			} else {
+				auxv->a_un.a_val = 0;
+			}
 			break;
 		}
 		auxv++;
@@ -59,6 +78,8 @@ void so_start_exec(so_exec_t *exec, char *argv[])
 	int *pargc;
 
 	fix_auxv(exec->base_addr, __environ);
+	if (before_jump)
+		before_jump();
 	/* fix argv to use the one from the main prog */
 	argv--;
 
@@ -80,38 +101,23 @@ void so_start_exec(so_exec_t *exec, char *argv[])
 		::"m"(exec->entry), "m"(argv) :);
 }
 
-so_exec_t *so_parse_exec(char *path)
+so_exec_t *so_parse_exec_hdr(char *hdr, int ret)
 {
 	so_exec_t *exec = NULL;
 	so_seg_t *seg;
-	char hdr[BUFSIZE];
-	int ret;
 	Elf32_Ehdr *ehdr;
 	Elf32_Phdr *phdr;
 	int i;
 	int j;
 	int num_load_phdr;
 	int pagesz;
-	int fd;
 	size_t diff;
 
 	pagesz = getpagesize();
 
-	fd = open(path, O_RDONLY);
-	if (fd < 0) {
-		perror("open");
-		goto out;
-	}
-
-	ret = read(fd, hdr, BUFSIZE);
-	if (ret < 0) {
-		perror("read");
-		goto out_close;
-	}
-
 	if (ret < (sizeof(Elf32_Ehdr) + sizeof(Elf32_Phdr))) {
 		fprintf(stderr, "file too small\n");
-		goto out_close;
+		goto out;
 	}
 
 	ehdr = (Elf32_Ehdr *)hdr;
@@ -123,54 +129,54 @@ so_exec_t *so_parse_exec(char *path)
 	    ehdr->e_ident[EI_MAG2] != ELFMAG2 ||
 	    ehdr->e_ident[EI_MAG3] != ELFMAG3) {
 		fprintf(stderr, "not an ELF file: invalid magic\n");
-		goto out_close;
+		goto out;
 	}
 
 	if (ehdr->e_ident[EI_CLASS] != ELFCLASS32) {
 		fprintf(stderr, "not a 32-bit ELF file\n");
-		goto out_close;
+		goto out;
 	}
 
 	if (ehdr->e_ident[EI_DATA] != ELFDATA2LSB) {
 		fprintf(stderr, "not a LSB ELF file\n");
-		goto out_close;
+		goto out;
 	}
 
 	if (ehdr->e_ident[EI_VERSION] != EV_CURRENT) {
 		fprintf(stderr, "invalid EI_VERSION\n");
-		goto out_close;
+		goto out;
 	}
 
 	if (ehdr->e_ident[EI_OSABI] != ELFOSABI_GNU &&
 	    ehdr->e_ident[EI_OSABI] != ELFOSABI_SYSV) {
 		fprintf(stderr, "invalid ABI\n");
-		goto out_close;
+		goto out;
 	}
 
 	if (ehdr->e_type != ET_EXEC) {
 		fprintf(stderr, "invalid executable type\n");
-		goto out_close;
+		goto out;
 	}
 
 	if (ehdr->e_machine != EM_386) {
 		fprintf(stderr, "invalid machine\n");
-		goto out_close;
+		goto out;
 	}
 
 	if (ehdr->e_version != EV_CURRENT) {
 		fprintf(stderr, "invalid version\n");
-		goto out_close;
+		goto out;
 	}
 
 	if (ret < (sizeof(Elf32_Ehdr) + ehdr->e_phnum * ehdr->e_phentsize)) {
 		fprintf(stderr, "too many program headers\n");
-		goto out_close;
+		goto out;
 	}
 
 	exec = malloc(sizeof(*exec));
 	if (!exec) {
 		fprintf(stderr, "out of memory\n");
-		goto out_close;
+		goto out;
 	}
 
 	num_load_phdr = 0;
@@ -212,6 +218,31 @@ so_exec_t *so_parse_exec(char *path)
 		}
 	}
 
+out:
+	return exec;
+}
+
+so_exec_t *so_parse_exec(char *path)
+{
+	so_exec_t *exec = NULL;
+	char hdr[BUFSIZE];
+	int ret;
+	int fd;
+
+	fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		perror("open");
+		goto out;
+	}
+
+	ret = read(fd, hdr, BUFSIZE);
+	if (ret < 0) {
+		perror("read");
+		goto out_close;
+	}
+
+	exec = so_parse_exec_hdr(hdr, ret);
+
 out_close:
 	close(fd);
 out:
@@ -45,6 +45,26 @@ typedef struct so_exec {
 /* parse an executable file */
 so_exec_t *so_parse_exec(char *path);
 
+/*
+ * parse the first bytes of an executable (at most EXEC_HDR_SIZE bytes are
+ * needed), already read in memory
+ */
+#define EXEC_HDR_SIZE 1024
+so_exec_t *so_parse_exec_hdr(char *hdr, int size);
+
+/*
+ * auxv entry type used to publish the loader's hint page; it replaces the
+ * AT_EXECFN entry (which is cleared otherwise)
+ */
+#define AT_SO_HINT 0x534f4801
+void so_set_hint_page(uintptr_t addr);
+
+/*
+ * function called by so_start_exec right before jumping to the entry point,
+ * after the auxiliary vector is fixed
+ */
+void so_set_before_jump(void (*fn)(void));
+
 /*
  * start an executable file, previously parsed in a so_exec_t structure
  * (jumps to the executable's entry point)
@@ -0,0 +1,236 @@
+/*
+ * Resident footprint of the loaded segments
+ *
+ * 2018, Operating Systems
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+
+#include "footprint.h"
+#include "config.h"
+#include "threads.h"
+#include "utils.h"
+
+/* bitii unei intrari din /proc/self/pagemap */
+#define PM_PRESENT	(1ull << 63)
+#define PM_SWAPPED	(1ull << 62)
+#define PM_FILE		(1ull << 61)
+#define PM_EXCLUSIVE	(1ull << 56)
+#define PM_SOFT_DIRTY	(1ull << 55)
+#define PM_PFN_MASK	((1ull << 55) - 1)
+
+/*
+ * numarul de pagini citite dintr-o data din pagemap; buffer-ele sunt pe
+ * stiva, ca footprint_sample sa poata fi apelata din mai multe thread-uri
+ */
+#define SAMPLE_BATCH	512
+
+static int pagemap_fd = -1;
+/* /sys/kernel/mm/page_idle/bitmap (doar cu privilegii) */
+static int idle_fd = -1;
+/* PFN-ul paginii zero (0 daca PFN-urile nu sunt vizibile) */
+static uint64_t zero_pfn;
+
+static so_exec_t *fp_exec;
+static unsigned int *fp_pages_no;
+
+/* intoarce intrarea din pagemap a paginii addr (0 la eroare) */
+static uint64_t pagemap_entry(uintptr_t addr)
+{
+	uint64_t entry;
+
+	if (pread(pagemap_fd, &entry, sizeof(entry),
+		  addr / getpagesize() * sizeof(entry)) != sizeof(entry))
+		return 0;
+
+	return entry;
+}
+
+/* afla PFN-ul paginii zero, citind o pagina anonima neinitializata */
+static void find_zero_pfn(void)
+{
+	volatile char *page;
+
+	page = mmap(NULL, getpagesize(), PROT_READ,
+		    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (page == MAP_FAILED)
+		return;
+
+	(void)page[0];
+	zero_pfn = pagemap_entry((uintptr_t)page) & PM_PFN_MASK;
+	munmap((void *)page, getpagesize());
+}
+
+void footprint_init(void)
+{
+	if (pagemap_fd >= 0)
+		return;
+
+	pagemap_fd = open("/proc/self/pagemap", O_RDONLY);
+	find_zero_pfn();
+
+	/* fara PFN-uri, bitmap-ul paginilor inactive nu poate fi folosit */
+	if (zero_pfn)
+		idle_fd = open("/sys/kernel/mm/page_idle/bitmap", O_RDWR);
+}
+
+void footprint_mark_speculative(uintptr_t addr, unsigned int pages)
+{
+	uint64_t entry, pfn, bits;
+	unsigned int i;
+
+	if (idle_fd < 0)
+		return;
+
+	for (i = 0; i < pages; i++, addr += getpagesize()) {
+		entry = pagemap_entry(addr);
+		pfn = entry & PM_PFN_MASK;
+		if (!(entry & PM_PRESENT) || !pfn)
+			continue;
+
+		bits = 1ull << (pfn % 64);
+		pwrite(idle_fd, &bits, sizeof(bits), pfn / 64 * sizeof(bits));
+	}
+}
+
+/* intoarce 1 daca pagina fizica pfn nu a fost accesata de la marcare */
+static int page_is_idle(uint64_t pfn)
+{
+	uint64_t bits;
+
+	if (pread(idle_fd, &bits, sizeof(bits), pfn / 64 * sizeof(bits)) !=
+	    sizeof(bits))
+		return 0;
+
+	return (bits >> (pfn % 64)) & 1;
+}
+
+void footprint_sample(so_exec_t *exec, unsigned int *pages_no,
+		      int seg_index, struct seg_footprint *fp)
+{
+	uint64_t entries[SAMPLE_BATCH];
+	unsigned char vec[SAMPLE_BATCH];
+	so_seg_t *segment = &exec->segments[seg_index];
+	uint8_t *states = segment->data;
+	int page_size = getpagesize();
+	unsigned int first, count, i;
+	uint64_t entry, pfn;
+	uintptr_t addr;
+
+	memset(fp, 0, sizeof(*fp));
+	fp->pages = pages_no[seg_index];
+	fp->wasted = idle_fd >= 0 ? 0 : -1;
+	if (!states)
+		return;
+
+	for (first = 0; first < pages_no[seg_index]; first += count) {
+		count = pages_no[seg_index] - first;
+		if (count > SAMPLE_BATCH)
+			count = SAMPLE_BATCH;
+
+		addr = segment->vaddr + (uintptr_t)first * page_size;
+		if (mincore((void *)addr, (size_t)count * page_size, vec) < 0)
+			memset(vec, 0, count);
+		if (pread(pagemap_fd, entries, count * sizeof(*entries),
+			  addr / page_size * sizeof(*entries)) !=
+		    (ssize_t)(count * sizeof(*entries)))
+			memset(entries, 0, sizeof(entries));
+
+		for (i = 0; i < count; i++) {
+			if (states[first + i] == PAGE_UNMAPPED)
+				continue;
+
+			fp->mapped++;
+			fp->resident += vec[i] & 1;
+
+			entry = entries[i];
+			pfn = entry & PM_PFN_MASK;
+			if (entry & PM_SWAPPED)
+				fp->swapped++;
+			if (entry & PM_SOFT_DIRTY)
+				fp->dirty++;
+
+			/*
+			 * fara PFN-uri, pagina zero este o pagina anonima
+			 * prezenta, dar nemapata exclusiv
+			 */
+			if ((entry & PM_PRESENT) &&
+			    (zero_pfn ? pfn == zero_pfn :
+			     !(entry & (PM_EXCLUSIVE | PM_FILE))))
+				fp->zero_page++;
+			else if ((entry & PM_PRESENT) &&
+				 !(entry & PM_EXCLUSIVE))
+				fp->shared++;
+
+			if (states[first + i] != PAGE_SPECULATIVE)
+				continue;
+
+			fp->speculative++;
+			if (idle_fd >= 0 && (entry & PM_PRESENT) &&
+			    page_is_idle(pfn))
+				fp->wasted++;
+		}
+	}
+}
+
+void footprint_report(so_exec_t *exec, unsigned int *pages_no)
+{
+	struct seg_footprint fp;
+	char wasted[32];
+	int i;
+
+	for (i = 0; i < exec->segments_no; i++) {
+		footprint_sample(exec, pages_no, i, &fp);
+
+		if (fp.wasted < 0)
+			strcpy(wasted, "n/a");
+		else
+			snprintf(wasted, sizeof(wasted), "%lld",
+				 (long long)fp.wasted);
+
+		fprintf(stderr, "so_loader: footprint seg=%d pages=%llu "
+			"mapped=%llu resident=%llu dirty=%llu shared=%llu "
+			"zero=%llu swapped=%llu speculative=%llu wasted=%s\n",
+			i, (unsigned long long)fp.pages,
+			(unsigned long long)fp.mapped,
+			(unsigned long long)fp.resident,
+			(unsigned long long)fp.dirty,
+			(unsigned long long)fp.shared,
+			(unsigned long long)fp.zero_page,
+			(unsigned long long)fp.swapped,
+			(unsigned long long)fp.speculative, wasted);
+	}
+}
+
+static void *footprint_sampler(void *arg)
+{
+	for (;;) {
+		usleep(so_cfg.footprint * 1000);
+		footprint_report(fp_exec, fp_pages_no);
+	}
+
+	return NULL;
+}
+
+void footprint_start(so_exec_t *exec, unsigned int *pages_no)
+{
+	int fd;
+
+	/* soft-dirty va marca doar paginile scrise de acum inainte */
+	fd = open("/proc/self/clear_refs", O_WRONLY);
+	if (fd >= 0) {
+		write(fd, "4", 1);
+		close(fd);
+	}
+
+	if (so_cfg.footprint > 0) {
+		fp_exec = exec;
+		fp_pages_no = pages_no;
+		loader_thread_start(footprint_sampler, NULL);
+	}
+}
@@ -0,0 +1,73 @@
+/*
+ * Resident footprint of the loaded segments
+ *
+ * 2018, Operating Systems
+ */
+
+#ifndef SO_FOOTPRINT_H_
+#define SO_FOOTPRINT_H_
+
+#include <stdint.h>
+
+#include "exec_parser.h"
+
+/* starea paginilor din vectorul so_seg_t.data */
+#define PAGE_UNMAPPED		0
+/* pagina a fost mapata la un page fault */
+#define PAGE_FAULTED		1
+/* pagina a fost mapata in avans (prefault, fault-around, eager) */
+#define PAGE_SPECULATIVE	2
+/* pagina este mapata sau eliberata chiar acum de un thread al loader-ului */
+#define PAGE_BUSY		3
+
+/* footprint-ul unui segment, esantionat la un moment dat */
+struct seg_footprint {
+	/* paginile segmentului si cele mapate de loader */
+	uint64_t pages;
+	uint64_t mapped;
+	uint64_t speculative;
+	/* paginile prezente in memorie (mincore) */
+	uint64_t resident;
+	/* paginile scrise de la pornirea programului (soft-dirty) */
+	uint64_t dirty;
+	/* paginile fizice mapate si in alte locuri (nu exclusiv) */
+	uint64_t shared;
+	/* paginile mapate pe pagina zero a kernel-ului */
+	uint64_t zero_page;
+	/* paginile evacuate in swap */
+	uint64_t swapped;
+	/*
+	 * paginile mapate in avans si neaccesate de atunci (page_idle);
+	 * -1 daca nu se poate determina (necesita privilegii)
+	 */
+	int64_t wasted;
+};
+
+/*
+ * deschide pagemap-ul si bitmap-ul paginilor inactive; se apeleaza o
+ * singura data, in so_execute, inainte ca paginile sa fie mapate in avans
+ * (apelurile de mai jos nu mai fac nicio initializare)
+ */
+void footprint_init(void);
+
+/*
+ * pregateste esantionarea: porneste urmarirea paginilor scrise si, daca
+ * SO_LOADER_FOOTPRINT=<ms> este setat, thread-ul care afiseaza periodic
+ * footprint-ul; se apeleaza chiar inainte de salt
+ */
+void footprint_start(so_exec_t *exec, unsigned int *pages_no);
+
+/*
+ * marcheaza paginile [addr, addr + pages * page_size), abia mapate in
+ * avans, ca neaccesate (daca page_idle este disponibil)
+ */
+void footprint_mark_speculative(uintptr_t addr, unsigned int pages);
+
+/* esantioneaza footprint-ul segmentului seg_index */
+void footprint_sample(so_exec_t *exec, unsigned int *pages_no,
+		      int seg_index, struct seg_footprint *fp);
+
+/* afiseaza (pe stderr) footprint-ul tuturor segmentelor */
+void footprint_report(so_exec_t *exec, unsigned int *pages_no);
+
+#endif /* SO_FOOTPRINT_H_ */
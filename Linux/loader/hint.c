@@ -0,0 +1,73 @@
+/*
+ * Guest prefetch hints
+ *
+ * 2018, Operating Systems
+ */
+
+#include <limits.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+#include "hint.h"
+
+static struct hint_page *hint;
+
+uintptr_t hint_init(void)
+{
+	void *page;
+	int i;
+
+	page = mmap(NULL, getpagesize(), PROT_READ | PROT_WRITE,
+		    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (page == MAP_FAILED)
+		return 0;
+
+	hint = page;
+	hint->magic = HINT_MAGIC;
+	for (i = 0; i < HINT_SLOTS; i++)
+		hint->ring[i].seq = i;
+
+	return (uintptr_t)hint;
+}
+
+void hint_next(struct hint_req *req)
+{
+	struct hint_req *slot;
+	uint32_t tail, head;
+
+	tail = hint->tail;
+	slot = &hint->ring[tail & (HINT_SLOTS - 1)];
+
+	for (;;) {
+		if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) == tail + 1)
+			break;
+
+		/*
+		 * pozitia a fost rezervata, dar cererea nu este inca scrisa;
+		 * altfel inelul este gol si asteptam modificarea lui head
+		 */
+		head = __atomic_load_n(&hint->head, __ATOMIC_ACQUIRE);
+		if (head != tail)
+			sched_yield();
+		else
+			syscall(SYS_futex, &hint->head, FUTEX_WAIT_PRIVATE,
+				head, NULL, NULL, 0);
+	}
+
+	req->start = slot->start;
+	req->length = slot->length;
+	req->mode = slot->mode;
+
+	__atomic_store_n(&slot->seq, tail + HINT_SLOTS, __ATOMIC_RELEASE);
+	hint->tail = tail + 1;
+}
+
+void hint_complete(void)
+{
+	__atomic_fetch_add(&hint->done, 1, __ATOMIC_RELEASE);
+	syscall(SYS_futex, &hint->done, FUTEX_WAKE_PRIVATE, INT_MAX,
+		NULL, NULL, 0);
+}
@@ -0,0 +1,57 @@
+/*
+ * Guest prefetch hints
+ *
+ * 2018, Operating Systems
+ */
+
+#ifndef SO_HINT_H_
+#define SO_HINT_H_
+
+#include <stdint.h>
+
+#define HINT_MAGIC	0x544e4948	/* "HINT" */
+
+/* numarul de intrari din inel (putere a lui 2) */
+#define HINT_SLOTS	128
+
+/* operatiile cerute de program */
+#define HINT_POPULATE	1	/* mapeaza paginile zonei */
+#define HINT_DROP	2	/* elibereaza paginile (continutul se pierde) */
+
+/*
+ * o cerere: zona [start, start + length) si operatia. seq implementeaza
+ * inelul fara lock-uri (Vyukov): intrarea i porneste cu seq = i; un
+ * program care a rezervat pozitia pos (CAS pe head) scrie cererea si
+ * apoi seq = pos + 1; loader-ul o consuma si seteaza seq = pos + HINT_SLOTS
+ */
+struct hint_req {
+	uint32_t start;
+	uint32_t length;
+	uint32_t mode;
+	uint32_t seq;
+};
+
+/*
+ * pagina de indicii, la adresa publicata in auxv (AT_SO_HINT). Dupa ce
+ * scrie o cerere, programul trezeste loader-ul cu FUTEX_WAKE pe head;
+ * done este numarul de cereri tratate (in ordine), pe care programul
+ * poate astepta cu FUTEX_WAIT
+ */
+struct hint_page {
+	uint32_t magic;		/* offset 0 */
+	uint32_t head;		/* offset 4 */
+	uint32_t tail;		/* offset 8 */
+	uint32_t done;		/* offset 12 */
+	struct hint_req ring[HINT_SLOTS];	/* offset 16 */
+};
+
+/* mapeaza pagina de indicii; intoarce adresa ei sau 0 */
+uintptr_t hint_init(void);
+
+/* asteapta (blocant) urmatoarea cerere si o scoate din inel */
+void hint_next(struct hint_req *req);
+
+/* marcheaza cererea scoasa ca tratata si trezeste programele care asteapta */
+void hint_complete(void);
+
+#endif /* SO_HINT_H_ */
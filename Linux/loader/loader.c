@@ -4,29 +4,102 @@
  * 2018, Operating Systems
  */
 
+/* mremap */
+#define _GNU_SOURCE
+
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 #include <unistd.h>
 #include <signal.h>
+#include <sched.h>
 #include <sys/mman.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
+#include <pthread.h>
 
 #include "loader.h"
 #include "exec_parser.h"
 #include "utils.h"
+#include "config.h"
+#include "plan_cache.h"
+#include "stats.h"
+#include "numa.h"
+#include "reach.h"
+#include "manifest.h"
+#include "symexport.h"
+#include "zero_index.h"
+#include "source.h"
+#include "threads.h"
+#include "page_ops.h"
+#include "trace.h"
+#include "packed.h"
+#include "tune.h"
+#include "pool.h"
+#include "perf_counters.h"
+#include "footprint.h"
+#include "actions.h"
+#include "hint.h"
+#include "populate.h"
 
 #define INVALID_SEGMENT	-1
 
+/*
+ * dimensiunea bucatilor in care sunt impartite segmentele la popularea
+ * eager (fiecare bucata este tratata de un singur thread)
+ */
+#define EAGER_CHUNK	(4 << 20)
+
+/*
+ * masurarea duratei fiecarei etape a tratarii unui page fault; activata
+ * doar in bench/microbench.c (SO_PHASE_TIMING), altfel nu costa nimic
+ */
+enum fault_phase {
+	PHASE_SEGMENT,
+	PHASE_MAP,
+	PHASE_ZERO,
+	PHASE_READ,
+	PHASE_PROTECT,
+	PHASES_NO,
+};
+
+#ifdef SO_PHASE_TIMING
+static uint64_t phase_ns[PHASES_NO];
+
+#define PHASE(phase, stmt)						\
+	do {								\
+		uint64_t phase_start = stats_now();			\
+		stmt;							\
+		phase_ns[phase] += stats_now() - phase_start;		\
+	} while (0)
+#else
+#define PHASE(phase, stmt)	do { stmt; } while (0)
+#endif
+
 static so_exec_t *exec;
 
 /* va retine default handler-ul semnalului SIGSEGV */
 static void (*sigsegv_sig_default_handler)(int, siginfo_t *, void *);
 
-/* file descriptor-ul care identifica instanta de fisier deschisa */
-static int file_descriptor;
+/*
+ * sursa din care sunt citite datele paginilor (fisier, pipe sau server
+ * de intervale)
+ */
+static struct so_source *source;
+
+/* numarul de pagini din fiecare segment (calculat in so_execute) */
+static unsigned int *pages_no;
+
+/* actiunile precompilate ale paginilor fiecarui segment */
+static struct action_table *actions;
+
+/*
+ * identitatea executabilului (cheia intrarilor din cache); NULL daca
+ * cache-ul este dezactivat
+ */
+static struct stat exec_stat;
+static struct stat *exec_key;
 
 /*
  * Intoarce index-ul segmentului din care face parte addr sau
@@ -57,57 +130,512 @@ static int get_segment_index(uintptr_t addr)
 	return INVALID_SEGMENT;
 }
 
-/* Zeroieste o zona de memorie de o anumita lungime */
-void zero_memory(so_seg_t *segment, uintptr_t addr, int size)
+/*
+ * executa actiunea precompilata a unei pagini, scriind continutul ei la
+ * dest (memorie proaspat alocata, deci deja zero)
+ */
+static void apply_action(struct page_action act, void *dest)
 {
-	char *addr_start = (char *)addr;
-	char *addr_helper = (char *)segment->vaddr + segment->file_size;
-	int length = size;
+	int page_size = getpagesize();
+	ssize_t len, ret;
 
-	if ((char *)addr + size < addr_helper)
-		return;
+	switch (act.kind) {
+	case ACTION_ZERO:
+		break;
+	case ACTION_FILE_ZERO:
+		STATS_ADD(zero_skipped, 1);
+		break;
+	case ACTION_COPY:
+	case ACTION_COPY_ZERO:
+		len = act.kind == ACTION_COPY ? page_size : act.len;
+		STATS_ADD(bytes_read, len);
+
+		PHASE(PHASE_READ,
+		      ret = source_read(source, dest, len, act.offset));
+		DIE(ret != len, "read failed");
+
+		if (act.kind == ACTION_COPY_ZERO)
+			PHASE(PHASE_ZERO, page_zero((char *)dest + len,
+						    page_size - len));
+		break;
+	}
+}
+
+/* paginile fara date de citit, care sunt deja zero dupa alocare */
+static int action_is_zero(struct page_action act)
+{
+	return act.kind == ACTION_ZERO ||
+	       (act.kind == ACTION_FILE_ZERO && !manifest_enabled());
+}
+
+/*
+ * intoarce vectorul de stare al paginilor segmentului; vectorul este
+ * alocat la prima utilizare, cu toate paginile marcate ca nemapate
+ */
+static uint8_t *page_states(int seg_index)
+{
+	if (!exec->segments[seg_index].data) {
+		exec->segments[seg_index].data = calloc(pages_no[seg_index],
+							sizeof(uint8_t));
+
+		DIE(!exec->segments[seg_index].data, "calloc failed.");
+	}
+
+	return exec->segments[seg_index].data;
+}
+
+/*
+ * revendica pagina (starea from -> PAGE_BUSY); thread-ul pentru indicii
+ * mapeaza si elibereaza pagini in paralel cu handler-ul, deci pagina este
+ * revendicata atomic inainte de a fi mapata sau eliberata
+ */
+static int page_claim(int seg_index, int page_index, uint8_t from)
+{
+	return __atomic_compare_exchange_n(&page_states(seg_index)[page_index],
+					   &from, PAGE_BUSY, 0,
+					   __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+}
+
+static void page_set_state(int seg_index, int page_index, uint8_t state)
+{
+	__atomic_store_n(&page_states(seg_index)[page_index], state,
+			 __ATOMIC_RELEASE);
+}
+
+/*
+ * asteapta ca alt thread sa termine lucrul pe pagina; intoarce 1 daca
+ * pagina era revendicata
+ */
+static int page_wait(int seg_index, int page_index)
+{
+	uint8_t *state = &page_states(seg_index)[page_index];
+
+	if (__atomic_load_n(state, __ATOMIC_ACQUIRE) != PAGE_BUSY)
+		return 0;
+
+	while (__atomic_load_n(state, __ATOMIC_ACQUIRE) == PAGE_BUSY)
+		sched_yield();
+
+	return 1;
+}
+
+/*
+ * verifica digest-ul paginii abia citite (daca exista un manifest);
+ * paginile fara date in fisier (doar .bss) nu sunt verificate
+ */
+static int verify_page(int seg_index, int page_index, uintptr_t page_addr)
+{
+	static const char msg[] = "so_loader: page integrity check failed\n";
+	so_seg_t *segment = &exec->segments[seg_index];
+	uint64_t start_ns = 0;
+	int res;
+
+	if (!manifest_enabled() ||
+	    page_addr >= segment->vaddr + segment->file_size)
+		return 0;
+
+	if (so_stats)
+		start_ns = stats_now();
+
+	res = manifest_verify(seg_index, page_index, (void *)page_addr);
+
+	if (so_stats) {
+		STATS_ADD(verified, 1);
+		STATS_ADD(verify_ns, stats_now() - start_ns);
+	}
+
+	if (res < 0)
+		write(STDERR_FILENO, msg, sizeof(msg) - 1);
+
+	return res;
+}
+
+/*
+ * elibereaza paginile [addr, addr + len); in modelul cu rezervare zona
+ * redevine PROT_NONE (si zero), altfel este demapata
+ */
+static void release_pages(uintptr_t addr, size_t len)
+{
+	int res;
+
+	if (so_cfg.reserve) {
+		res = mprotect((void *)addr, len, PROT_NONE);
+		DIE(res < 0, "mprotect failed");
+		res = madvise((void *)addr, len, MADV_DONTNEED);
+		DIE(res < 0, "madvise failed");
+	} else {
+		res = munmap((void *)addr, len);
+		DIE(res < 0, "munmap failed");
+	}
+}
+
+/*
+ * mapeaza pagina page_index folosind o pagina din pool (deja alocata si
+ * zeroizata): datele sunt citite in pagina din pool, care este apoi mutata
+ * cu mremap peste adresa finala
+ */
+static int map_pool_page(int seg_index, int page_index, uintptr_t page_addr,
+			 void *page, struct page_action act)
+{
+	int page_size = getpagesize();
+	void *ret;
+	int res;
+
+	apply_action(act, page);
+
+	PHASE(PHASE_PROTECT, res = mprotect(page, page_size, act.prot));
+	DIE(res < 0, "mprotect failed");
+
+	PHASE(PHASE_MAP, ret = mremap(page, page_size, page_size,
+				      MREMAP_MAYMOVE | MREMAP_FIXED,
+				      (void *)page_addr));
+	DIE(ret == MAP_FAILED, "mremap failed");
+
+	if (verify_page(seg_index, page_index, page_addr) < 0) {
+		release_pages(page_addr, page_size);
+		return -1;
+	}
+
+	return 0;
+}
+
+/*
+ * mapeaza pagina page_index din segmentul seg_index: aloca memorie,
+ * zeroieste zona .bss, citeste datele din fisier si seteaza permisiunile
+ * segmentului. Pagina nu trebuie sa fie deja mapata.
+ * Intoarce -1 (pagina ramane nemapata) daca pagina nu corespunde
+ * manifestului de integritate.
+ */
+static int map_page(int seg_index, int page_index)
+{
+	int page_size = getpagesize();
+	struct page_action act;
+	uintptr_t page_addr;
+	void *ret;
+	int flags, res;
+
+	/* tot ce trebuie facut pentru pagina a fost calculat in so_execute */
+	act = action_lookup(&actions[seg_index], page_index);
+
+	/* calculam adresa de inceput a paginii de memorie */
+	page_addr = exec->segments[seg_index].vaddr + page_index * page_size;
+
+	/*
+	 * alocarea si zeroizarea paginii au fost facute in fundal; paginile
+	 * fara date din zona rezervata nu au nevoie de pool (un mprotect)
+	 */
+	if (so_cfg.pool && (!so_cfg.reserve || !action_is_zero(act))) {
+		ret = pool_get();
+		if (ret) {
+			if (map_pool_page(seg_index, page_index, page_addr,
+					  ret, act) < 0)
+				return -1;
+			ret = (void *)page_addr;
+			goto out_mapped;
+		}
+	}
+
+	if (so_cfg.reserve) {
+		/*
+		 * zona segmentului a fost rezervata (PROT_NONE) in so_execute,
+		 * deci pagina trebuie doar facuta accesibila; paginile fara
+		 * date de citit (.bss sau doar zero in fisier) sunt deja zero,
+		 * asa ca pentru ele ajunge un singur mprotect
+		 */
+		if (action_is_zero(act)) {
+			PHASE(PHASE_MAP, res = mprotect((void *)page_addr,
+							page_size, act.prot));
+			DIE(res < 0, "mprotect failed");
+			apply_action(act, (void *)page_addr);
+			ret = (void *)page_addr;
+			goto out_mapped;
+		}
+
+		PHASE(PHASE_MAP, res = mprotect((void *)page_addr, page_size,
+						act.prot | PROT_WRITE));
+		DIE(res < 0, "mprotect failed");
+		ret = (void *)page_addr;
+	} else {
+		flags = MAP_PRIVATE | MAP_FIXED | MAP_ANONYMOUS;
+		/* alocam memorie */
+		PHASE(PHASE_MAP, ret = mmap((void *)page_addr, page_size,
+					    PROT_WRITE, flags, -1, 0));
+		DIE(ret == MAP_FAILED, "mmap failed.");
+
+		/* plasam pagina conform politicii NUMA, inainte de acces */
+		numa_place(seg_index, ret, page_size);
+	}
+
+	/* copiem datele din fisier si zeroim restul paginii, daca e cazul */
+	apply_action(act, (void *)page_addr);
+
+	/* refuzam maparea paginilor modificate */
+	if (verify_page(seg_index, page_index, page_addr) < 0) {
+		release_pages(page_addr, page_size);
+		return -1;
+	}
+
+	/*
+	 * schimbam permisiunile paginii(pagina trebuie sa aiba aceleasi
+	 * permisiunii ca segmentul din care face parte); daca segmentul
+	 * este writable, permisiunile au fost deja setate
+	 */
+	if (!so_cfg.reserve || !(act.prot & PROT_WRITE)) {
+		PHASE(PHASE_PROTECT, res = mprotect((void *)page_addr,
+						    page_size, act.prot));
+		DIE(res < 0, "mprotect failed");
+	}
 
-	if (addr < (uintptr_t)addr_helper)
-		addr_start += addr_helper - (char *)addr;
+out_mapped:
+	/* marcam in vectorul data ca pagina a fost mapata */
+	page_set_state(seg_index, page_index, PAGE_FAULTED);
+
+	if (so_stats)
+		numa_account(ret);
+
+	return 0;
+}
 
-	addr_helper = (char *)segment->vaddr + segment->mem_size;
-	if ((char *)addr + size > addr_helper)
-		length = addr_helper - addr_start;
-	else
-		length = ((char *)addr + size) - addr_start;
+/*
+ * pagina este copiata integral dintr-un fisier obisnuit, de la un offset
+ * aliniat, deci poate fi mapata direct din executabil (fara politica
+ * NUMA, care trebuie aplicata inainte de alocarea paginilor)
+ */
+static int page_is_direct(int seg_index, unsigned int page_index)
+{
+	struct page_action act = action_lookup(&actions[seg_index], page_index);
 
-	memset((void *)addr_start, 0, length);
+	return so_cfg.kernel_populate && source->fd >= 0 && !so_cfg.numa &&
+	       act.kind == ACTION_COPY && !(act.offset % getpagesize());
 }
 
 /*
- * citeste un numar de bytes din fiserul executabil
- * si ii salveaza la adresa addr
+ * mapeaza paginile [first, end) direct din executabil; kernel-ul le
+ * populeaza pe toate dintr-un singur apel
  */
-void read_data(so_seg_t *segment, uintptr_t addr, int size)
+static int fill_direct(int seg_index, unsigned int first, unsigned int end)
 {
-	int bytes_read;
-	uintptr_t addr_helper = segment->vaddr + segment->file_size;
-	int index = 0;
-	unsigned int offset = segment->offset;
-	off_t pos;
-	char *start_addr = (char *)addr;
+	int page_size = getpagesize();
+	struct page_action act = action_lookup(&actions[seg_index], first);
+	size_t len = (size_t)(end - first) * page_size;
+	void *addr;
+
+	addr = (void *)(exec->segments[seg_index].vaddr + first * page_size);
+	if (populate_file(addr, len, act.prot, source->fd, act.offset) < 0)
+		return -1;
+
+	STATS_ADD(bytes_read, len);
+	STATS_ADD(populate_direct, end - first);
+
+	return 0;
+}
 
-	if (addr + size > addr_helper) {
-		size = addr_helper - addr;
-		if (size < 0)
-			return;
+/*
+ * completeaza in user space paginile [first, end): zona devine writable
+ * cu un singur apel, paginile consecutive copiate integral din fisier
+ * sunt citite impreuna, apoi permisiunile finale sunt setate pe toata
+ * zona, iar paginile ramase neatinse (zero) sunt populate de kernel.
+ * Cu pagina de indicii programul ruleaza in paralel, deci zona este
+ * completata separat si mutata la adresa finala (mremap), pentru ca
+ * programul sa nu vada pagini partial completate.
+ */
+static void fill_user(int seg_index, unsigned int first, unsigned int end)
+{
+	struct action_table *table = &actions[seg_index];
+	int page_size = getpagesize();
+	uintptr_t addr = exec->segments[seg_index].vaddr + first * page_size;
+	size_t len = (size_t)(end - first) * page_size;
+	struct page_action act;
+	unsigned int i, next;
+	ssize_t size, ret;
+	char *dest;
+	int res;
+
+	if (so_cfg.hints || !so_cfg.reserve) {
+		dest = mmap(so_cfg.hints ? NULL : (void *)addr, len,
+			    PROT_READ | PROT_WRITE, MAP_PRIVATE |
+			    MAP_ANONYMOUS | (so_cfg.hints ? 0 : MAP_FIXED),
+			    -1, 0);
+		DIE(dest == MAP_FAILED, "mmap failed.");
+		numa_place(seg_index, dest, len);
+	} else {
+		dest = (char *)addr;
+		res = mprotect(dest, len, PROT_READ | PROT_WRITE);
+		DIE(res < 0, "mprotect failed");
 	}
 
-	offset += addr - segment->vaddr;
-	pos = lseek(file_descriptor, offset, SEEK_SET);
-	DIE(pos < 0, "lseek failed");
+	for (i = first; i < end; i = next) {
+		act = action_lookup(table, i);
+		next = i + 1;
+		if (act.kind != ACTION_COPY) {
+			apply_action(act, dest + (i - first) * page_size);
+			continue;
+		}
+
+		while (next < end &&
+		       action_lookup(table, next).kind == ACTION_COPY)
+			next++;
 
-	while (size > 0) {
-		bytes_read = read(file_descriptor, start_addr + index, size);
-		DIE(bytes_read < 0, "read failed");
-		size -= bytes_read;
-		index += bytes_read;
+		size = (ssize_t)(next - i) * page_size;
+		STATS_ADD(bytes_read, size);
+		ret = source_read(source, dest + (i - first) * page_size,
+				  size, act.offset);
+		DIE(ret != size, "read failed");
 	}
+
+	res = mprotect(dest, len, table->prot);
+	DIE(res < 0, "mprotect failed");
+
+	if (so_cfg.hints) {
+		dest = mremap(dest, len, len, MREMAP_MAYMOVE | MREMAP_FIXED,
+			      (void *)addr);
+		DIE(dest == MAP_FAILED, "mremap failed");
+	}
+
+	/*
+	 * paginile tocmai au fost scrise, deci sunt deja prezente; daca
+	 * apelul esueaza, maparea ramane corecta, asa ca rezultatul este
+	 * ignorat
+	 */
+	(void)populate_kernel(dest, len, table->prot & PROT_WRITE);
+}
+
+/*
+ * motorul de populare, folosit de toate mecanismele care mapeaza pagini
+ * in avans (eager, prefault, fault-around, indicii): paginile
+ * [first, end) ale segmentului, revendicate de apelant, sunt mapate cu
+ * cat mai putine apeluri de sistem si primesc starea state. Intoarce
+ * numarul de pagini mapate (cele care nu corespund manifestului raman
+ * nemapate).
+ */
+static unsigned int populate_run(int seg_index, unsigned int first,
+				 unsigned int end, uint8_t state)
+{
+	uintptr_t vaddr = exec->segments[seg_index].vaddr;
+	int page_size = getpagesize();
+	unsigned int i, next, mapped = 0;
+	uint64_t max;
+	int direct;
+
+	/*
+	 * o singura pagina: calea din handler (pool, un singur mprotect);
+	 * aceasta scrie pagina la adresa finala, deci nu si cu indicii
+	 */
+	if (end - first == 1 && !page_is_direct(seg_index, first) &&
+	    !so_cfg.hints) {
+		if (map_page(seg_index, first) < 0) {
+			page_set_state(seg_index, first, PAGE_UNMAPPED);
+			return 0;
+		}
+		page_set_state(seg_index, first, state);
+		mapped = 1;
+		goto out;
+	}
+
+	for (i = first; i < end; i = next) {
+		direct = page_is_direct(seg_index, i);
+		for (next = i + 1; next < end &&
+		     page_is_direct(seg_index, next) == direct; next++)
+			;
+		if (!direct || fill_direct(seg_index, i, next) < 0)
+			fill_user(seg_index, i, next);
+	}
+
+	for (i = first; i < end; i++) {
+		if (verify_page(seg_index, i, vaddr + i * page_size) < 0) {
+			release_pages(vaddr + i * page_size, page_size);
+			page_set_state(seg_index, i, PAGE_UNMAPPED);
+			continue;
+		}
+		page_set_state(seg_index, i, state);
+		if (so_stats)
+			numa_account((void *)(vaddr + i * page_size));
+		mapped++;
+	}
+
+out:
+	if (so_cfg.footprint && state == PAGE_SPECULATIVE)
+		footprint_mark_speculative(vaddr + first * page_size,
+					   end - first);
+
+	if (so_stats) {
+		STATS_ADD(populate_calls, 1);
+		STATS_ADD(populate_pages, mapped);
+		max = __atomic_load_n(&so_stats->populate_max,
+				      __ATOMIC_RELAXED);
+		while (mapped > max &&
+		       !__atomic_compare_exchange_n(&so_stats->populate_max,
+						    &max, mapped, 0,
+						    __ATOMIC_RELAXED,
+						    __ATOMIC_RELAXED))
+			;
+	}
+
+	return mapped;
+}
+
+/*
+ * interfata comuna de populare: mapeaza paginile nemapate din [first, end)
+ * ale segmentului, cate o secventa de pagini revendicate odata; intoarce
+ * numarul de pagini mapate
+ */
+static unsigned int populate_range(int seg_index, unsigned int first,
+				   unsigned int end, uint8_t state)
+{
+	unsigned int i, run = first, mapped = 0;
+
+	for (i = first; i < end; i++) {
+		if (page_claim(seg_index, i, PAGE_UNMAPPED))
+			continue;
+
+		if (run < i)
+			mapped += populate_run(seg_index, run, i, state);
+		run = i + 1;
+	}
+	if (run < end)
+		mapped += populate_run(seg_index, run, end, state);
+
+	return mapped;
+}
+
+/*
+ * mapeaza si urmatoarele SO_LOADER_FAULT_AROUND - 1 pagini ale segmentului
+ * (daca nu sunt deja mapate), anticipand un acces secvential
+ */
+static void fault_around(int seg_index, int page_index)
+{
+	unsigned int end, mapped;
+
+	end = page_index + so_cfg.fault_around;
+	if (end > pages_no[seg_index])
+		end = pages_no[seg_index];
+
+	/* STATS_ADD nu evalueaza valoarea fara statistici */
+	mapped = populate_range(seg_index, page_index + 1, end,
+				PAGE_SPECULATIVE);
+	STATS_ADD(faulted_around, mapped);
+}
+
+/*
+ * cu pagina de indicii, pagina poate fi mapata de thread-ul care o
+ * deserveste dupa page fault, dar inainte ca handler-ul sa ii citeasca
+ * starea; daca accesul (codul de eroare x86) este permis de permisiunile
+ * segmentului, page fault-ul este depasit si accesul trebuie doar reluat
+ */
+static int fault_is_stale(ucontext_t *uc, int seg_index)
+{
+	unsigned long err = uc->uc_mcontext.gregs[REG_ERR];
+	unsigned int perm = exec->segments[seg_index].perm;
+
+	if (!so_cfg.hints)
+		return 0;
+	/* bitul 1 - scriere, bitul 4 - executie */
+	if ((err & 0x2) && !(perm & PERM_W))
+		return 0;
+	if ((err & 0x10) && !(perm & PERM_X))
+		return 0;
+
+	return (perm & PERM_R) != 0;
 }
 
 /*
@@ -117,83 +645,389 @@ void read_data(so_seg_t *segment, uintptr_t addr, int size)
  */
 static void sigsegv_sig_handler(int signum, siginfo_t *info, void *ucont)
 {
-	int seg_index, nr_pages;
-	int page_size, page_index;
-	uintptr_t page_addr;
-	void *ret;
-	int flags, res;
+	int seg_index;
+	int page_index;
+	uint64_t start_ns = 0;
 
 	if (signum != SIGSEGV)
 		return;
 
+	if (so_stats)
+		start_ns = stats_now();
+
 	/*
 	 * obtinem indexul segmentului din care face parte pagina care contine
 	 * adresa care a cauzat page fault-ul
 	 */
-	seg_index = get_segment_index((uintptr_t)info->si_addr);
+	PHASE(PHASE_SEGMENT,
+	      seg_index = get_segment_index((uintptr_t)info->si_addr));
 
 	if (seg_index == INVALID_SEGMENT) {
 		sigsegv_sig_default_handler(signum, info, ucont);
 		return;
 	}
 
-	/* obtinem dimensiunea unei pagini de memorie */
-	page_size = getpagesize();
-
-	if (!exec->segments[seg_index].data) {
-		/* calculam numarul de pagini din segment */
-		nr_pages = ceil_(exec->segments[seg_index].mem_size * 1.0f
-						/ page_size * 1.0f);
-
-		/* marcam initial toate paginile ca fiind nemapate */
-		exec->segments[seg_index].data = calloc(nr_pages,
-							sizeof(uint8_t));
-
-		DIE(!exec->segments[seg_index].data, "calloc failed.");
-	}
-
 	/*
 	 * calculam indexul paginii din cadrul segmentului identificat
 	 * prin seg_index .
 	 */
 	page_index = ((uintptr_t)info->si_addr
-			- exec->segments[seg_index].vaddr) / page_size;
+			- exec->segments[seg_index].vaddr) / getpagesize();
 	/*
 	 * daca pagina este deja mapata, inseamna ca page fault-ul a fost
-	 * generat din cauza faptului ca pagina nu are permisiunile necesare
+	 * generat din cauza faptului ca pagina nu are permisiunile necesare;
+	 * daca thread-ul pentru indicii lucreaza (sau a lucrat) pe ea,
+	 * accesul este reluat
 	 */
-	if (*((uint8_t *)exec->segments[seg_index].data + page_index)) {
+	if (!page_claim(seg_index, page_index, PAGE_UNMAPPED)) {
+		if (!page_wait(seg_index, page_index) &&
+		    !fault_is_stale(ucont, seg_index))
+			sigsegv_sig_default_handler(signum, info, ucont);
+		return;
+	}
+
+	if (map_page(seg_index, page_index) < 0) {
+		page_set_state(seg_index, page_index, PAGE_UNMAPPED);
 		sigsegv_sig_default_handler(signum, info, ucont);
 		return;
 	}
 
-	/* calculam adresa de inceput a paginii de memorie */
-	page_addr = exec->segments[seg_index].vaddr + page_index * page_size;
+	trace_record((uintptr_t)info->si_addr);
 
-	flags = MAP_PRIVATE | MAP_FIXED | MAP_ANONYMOUS;
-	/* alocam memorie */
-	ret = mmap((void *)page_addr, page_size, PROT_WRITE, flags, -1, 0);
-	DIE(ret == MAP_FAILED, "mmap failed.");
+	if (so_cfg.fault_around > 1)
+		fault_around(seg_index, page_index);
 
-	/*
-	 * zeroim(daca este necesar-pagina sa fie in zona .bss)
-	 * zona de memorie
-	 */
-	zero_memory(&exec->segments[seg_index], page_addr, page_size);
+	if (so_stats) {
+		so_stats->faults++;
+		so_stats->fault_ns += stats_now() - start_ns;
 
-	/* citim datele paginii din fisierul executabil */
-	read_data(&exec->segments[seg_index], page_addr, page_size);
+		/* esantionam numarul de VMA-uri la 1, 2, 4, 8... fault-uri */
+		if (!(so_stats->faults & (so_stats->faults - 1)))
+			stats_sample_vmas();
+	}
+}
 
-	/*
-	 * schimbam permisiunile paginii(pagina trebuie sa aiba aceleasi
-	 * permisiunii ca segmentul din care face parte)
-	 */
-	res = mprotect((void *)page_addr, page_size,
-				exec->segments[seg_index].perm);
-	DIE(res < 0, "mprotect failed");
+/*
+ * rezerva intreaga zona de adrese a fiecarui segment (PROT_NONE, fara
+ * memorie alocata); page fault-urile doar fac paginile accesibile, astfel
+ * incat nu se creeaza cate un VMA pentru fiecare pagina, iar paginile
+ * vecine cu aceleasi permisiuni pot fi unite de kernel
+ */
+static void reserve_segments(void)
+{
+	int flags = MAP_PRIVATE | MAP_FIXED | MAP_ANONYMOUS | MAP_NORESERVE;
+	size_t size;
+	void *ret;
+	int i;
 
-	/* marcam in vectorul data ca pagina a fost mapata */
-	*((uint8_t *)exec->segments[seg_index].data + page_index) = 1;
+	for (i = 0; i < exec->segments_no; i++) {
+		size = (size_t)pages_no[i] * getpagesize();
+		if (!size)
+			continue;
+
+		ret = mmap((void *)exec->segments[i].vaddr, size, PROT_NONE,
+			   flags, -1, 0);
+		DIE(ret == MAP_FAILED, "mmap failed.");
+
+		/* politica NUMA se aplica o singura data, pe toata zona */
+		numa_place(i, ret, size);
+	}
+}
+
+/* populeaza bucata chunk a segmentului (cate o bucata per thread) */
+static void populate_chunk(int chunk, void *arg)
+{
+	int seg_index = *(int *)arg;
+	unsigned int pages = EAGER_CHUNK / getpagesize();
+	unsigned int first = chunk * pages, last, mapped;
+
+	last = first + pages;
+	if (last > pages_no[seg_index])
+		last = pages_no[seg_index];
+
+	mapped = populate_range(seg_index, first, last, PAGE_SPECULATIVE);
+	STATS_ADD(eager_pages, mapped);
+}
+
+/*
+ * populeaza (inainte de salt) tot segmentul: bucatile sunt impartite
+ * intre thread-urile loader-ului
+ */
+static void populate_segment(int seg_index)
+{
+	size_t size = (size_t)pages_no[seg_index] * getpagesize();
+	uint64_t start_ns = 0;
+
+	if (!size)
+		return;
+
+	if (so_stats)
+		start_ns = stats_now();
+
+	/* vectorul de stare este alocat inainte de pornirea thread-urilor */
+	page_states(seg_index);
+
+	loader_parallel_for((size + EAGER_CHUNK - 1) / EAGER_CHUNK,
+			    so_cfg.threads, populate_chunk, &seg_index);
+
+	if (so_stats)
+		STATS_ADD(eager_ns, stats_now() - start_ns);
+}
+
+/*
+ * mapeaza in avans paginile date (adrese de inceput de pagina); paginile
+ * din afara segmentelor sau deja mapate sunt ignorate
+ */
+static void prefault_pages(uintptr_t *pages, int count)
+{
+	int page_size = getpagesize();
+	int i, next, seg_index, page_index;
+	unsigned int mapped;
+
+	for (i = 0; i < count; i = next) {
+		next = i + 1;
+		seg_index = get_segment_index(pages[i]);
+		if (seg_index == INVALID_SEGMENT)
+			continue;
+
+		/* paginile consecutive ale segmentului sunt populate odata */
+		while (next < count &&
+		       pages[next] == pages[next - 1] + page_size &&
+		       get_segment_index(pages[next]) == seg_index)
+			next++;
+
+		page_index = (pages[i] - exec->segments[seg_index].vaddr)
+				/ page_size;
+		mapped = populate_range(seg_index, page_index,
+					page_index + next - i,
+					PAGE_SPECULATIVE);
+		STATS_ADD(prefaulted, mapped);
+	}
+}
+
+/*
+ * pornirea in paralel (SO_LOADER_PIPELINE): imediat dupa deschiderea
+ * sursei, un thread citeste antetul executabilului, apoi, cand planul de
+ * incarcare este cunoscut (de obicei din cache), datele paginii entry
+ * point-ului. Dupa rezervarea segmentelor, thread-ul mapeaza aceasta
+ * pagina si prima pagina a primului segment scriibil; so_start_exec il
+ * asteapta chiar inainte de salt, dupa fix_auxv.
+ */
+enum pipeline_step {
+	PIPELINE_STARTED,
+	/* antetul a fost citit (de thread) */
+	PIPELINE_HEADER,
+	/* planul de incarcare si sursa sunt gata (in so_execute) */
+	PIPELINE_PLAN,
+	/* paginile pot fi mapate (in so_execute) */
+	PIPELINE_READY,
+	/* so_execute a esuat, thread-ul se opreste (in so_execute) */
+	PIPELINE_CANCEL,
+};
+
+static pthread_t pipeline_thread;
+static int pipeline_running;
+static pthread_mutex_t pipeline_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t pipeline_cond = PTHREAD_COND_INITIALIZER;
+static enum pipeline_step pipeline_step;
+static char pipeline_hdr[EXEC_HDR_SIZE];
+static ssize_t pipeline_hdr_size;
+static uintptr_t pipeline_pages[2];
+static int pipeline_pages_no;
+
+/* pasii sunt marcati de ambele parti, deci doar in ordine crescatoare */
+static void pipeline_post(enum pipeline_step step)
+{
+	pthread_mutex_lock(&pipeline_lock);
+	if (pipeline_step < step)
+		pipeline_step = step;
+	pthread_cond_broadcast(&pipeline_cond);
+	pthread_mutex_unlock(&pipeline_lock);
+}
+
+/* intoarce pasul atins (PIPELINE_CANCEL daca so_execute a esuat) */
+static enum pipeline_step pipeline_await(enum pipeline_step step)
+{
+	enum pipeline_step reached;
+
+	pthread_mutex_lock(&pipeline_lock);
+	while (pipeline_step < step)
+		pthread_cond_wait(&pipeline_cond, &pipeline_lock);
+	reached = pipeline_step;
+	pthread_mutex_unlock(&pipeline_lock);
+
+	return reached;
+}
+
+/* citeste datele paginii addr, pentru ca maparea ei sa le gaseasca in cache */
+static void pipeline_read_page(uintptr_t addr)
+{
+	int page_size = getpagesize();
+	int seg_index = get_segment_index(addr);
+	so_seg_t *segment;
+	char *page;
+
+	if (seg_index == INVALID_SEGMENT)
+		return;
+
+	segment = &exec->segments[seg_index];
+	if (addr - segment->vaddr >= segment->file_size)
+		return;
+
+	page = malloc(page_size);
+	DIE(!page, "malloc failed.");
+	source_read(source, page, page_size,
+		    segment->offset + (addr - segment->vaddr));
+	free(page);
+}
+
+static void *pipeline_fetch(void *arg)
+{
+	int page_size = getpagesize();
+	int i;
+
+	(void)arg;
+	pipeline_hdr_size = source_read(source, pipeline_hdr,
+					sizeof(pipeline_hdr), 0);
+	pipeline_post(PIPELINE_HEADER);
+
+	if (pipeline_await(PIPELINE_PLAN) == PIPELINE_CANCEL)
+		return NULL;
+	/* prefault_pages cere adrese de inceput de pagina */
+	pipeline_pages_no = 0;
+	pipeline_pages[pipeline_pages_no++] = ALIGN_DOWN(exec->entry,
+							 page_size);
+	for (i = 0; i < exec->segments_no; i++)
+		if (exec->segments[i].perm & PERM_W) {
+			pipeline_pages[pipeline_pages_no++] =
+				ALIGN_DOWN(exec->segments[i].vaddr, page_size);
+			break;
+		}
+	pipeline_read_page(pipeline_pages[0]);
+
+	if (pipeline_await(PIPELINE_READY) == PIPELINE_CANCEL)
+		return NULL;
+	prefault_pages(pipeline_pages, pipeline_pages_no);
+
+	return NULL;
+}
+
+static void pipeline_wait(void)
+{
+	if (!pipeline_running)
+		return;
+
+	pthread_join(pipeline_thread, NULL);
+	pipeline_running = 0;
+}
+
+/* opreste thread-ul cand so_execute esueaza inainte de salt */
+static void pipeline_cancel(void)
+{
+	pipeline_post(PIPELINE_CANCEL);
+	pipeline_wait();
+}
+
+static void pipeline_start(void)
+{
+	/* fara thread, antetul este citit, iar paginile mapate, ca de obicei */
+	pipeline_running = pthread_create(&pipeline_thread, NULL,
+					  pipeline_fetch, NULL) == 0;
+	if (pipeline_running)
+		so_set_before_jump(pipeline_wait);
+}
+
+/* elibereaza paginile revendicate [first, end) ale segmentului */
+static void hint_release(int seg_index, unsigned int first, unsigned int end)
+{
+	int page_size = getpagesize();
+	unsigned int i;
+
+	if (first == end)
+		return;
+
+	release_pages(exec->segments[seg_index].vaddr + first * page_size,
+		      (end - first) * page_size);
+	for (i = first; i < end; i++)
+		page_set_state(seg_index, i, PAGE_UNMAPPED);
+	STATS_ADD(hint_dropped, end - first);
+}
+
+/*
+ * elibereaza paginile mapate [first, end) ale segmentului; paginile
+ * consecutive sunt eliberate impreuna
+ */
+static void hint_drop(int seg_index, unsigned int first, unsigned int end)
+{
+	unsigned int i, run = first;
+
+	for (i = first; i < end; i++) {
+		if (page_claim(seg_index, i, PAGE_FAULTED) ||
+		    page_claim(seg_index, i, PAGE_SPECULATIVE))
+			continue;
+
+		hint_release(seg_index, run, i);
+		run = i + 1;
+	}
+	hint_release(seg_index, run, end);
+}
+
+/* thread-ul care trateaza cererile scrise de program in pagina de indicii */
+static void *hint_service(void *arg)
+{
+	int page_size = getpagesize();
+	struct hint_req req;
+	uint64_t start, end, lo, hi;
+	unsigned int mapped;
+	so_seg_t *seg;
+	int i;
+
+	(void)arg;
+	for (;;) {
+		hint_next(&req);
+
+		start = req.start;
+		end = start + req.length;
+		for (i = 0; i < exec->segments_no; i++) {
+			seg = &exec->segments[i];
+			lo = start > seg->vaddr ? start : seg->vaddr;
+			hi = seg->vaddr + seg->mem_size;
+			if (end < hi)
+				hi = end;
+			if (lo >= hi)
+				continue;
+
+			lo = (lo - seg->vaddr) / page_size;
+			hi = ALIGN_UP(hi - seg->vaddr, page_size) / page_size;
+			if (req.mode == HINT_POPULATE) {
+				mapped = populate_range(i, lo, hi,
+							PAGE_SPECULATIVE);
+				STATS_ADD(hint_populated, mapped);
+			} else if (req.mode == HINT_DROP) {
+				hint_drop(i, lo, hi);
+			}
+		}
+
+		STATS_ADD(hints, 1);
+		hint_complete();
+	}
+
+	return NULL;
+}
+
+/* mapeaza pagina de indicii si porneste thread-ul care o deserveste */
+static void hint_start(void)
+{
+	uintptr_t page;
+
+	page = hint_init();
+	if (!page || get_segment_index(page) != INVALID_SEGMENT) {
+		fprintf(stderr, "so_loader: cannot map the hint page\n");
+		return;
+	}
+
+	so_set_hint_page(page);
+	loader_thread_start(hint_service, NULL);
 }
 
 /* inregistreaza handler-ul */
@@ -213,23 +1047,221 @@ static void record_sigsegv_sig_handler(void)
 
 int so_init_loader(void)
 {
+	config_init();
+	page_ops_init(so_cfg.simd);
+	populate_init();
+	if (so_cfg.stats || so_cfg.autotune)
+		stats_init();
 	record_sigsegv_sig_handler();
 
 	return -1;
 }
 
-int so_execute(char *path, char *argv[])
+/*
+ * calculeaza numarul de pagini din fiecare segment (layout-ul vectorilor
+ * de stare ai paginilor)
+ */
+static unsigned int *compute_pages_no(void)
 {
-	exec = so_parse_exec(path);
+	unsigned int *result;
+	int page_size = getpagesize();
+	int i;
+
+	result = malloc(exec->segments_no * sizeof(unsigned int));
+	DIE(!result, "malloc failed.");
+
+	/* in intregi: un float pierde ultima pagina peste 2^24 bytes */
+	for (i = 0; i < exec->segments_no; i++)
+		result[i] = ALIGN_UP(exec->segments[i].mem_size, page_size) /
+			    page_size;
+
+	return result;
+}
+
+/*
+ * obtine planul de incarcare al executabilului: din cache, daca exista o
+ * intrare valida pentru versiunea curenta a fisierului, altfel parsand
+ * executabilul (si salvand rezultatul in cache)
+ */
+static so_exec_t *load_plan(void)
+{
+	char hdr[EXEC_HDR_SIZE];
+	ssize_t size;
+
+	if (so_cfg.cache_dir && source->fd >= 0 &&
+	    fstat(source->fd, &exec_stat) == 0) {
+		exec_key = &exec_stat;
+		exec = plan_cache_load(exec_key, &pages_no);
+		if (exec)
+			return exec;
+	}
+
+	/* antetul este citit prin sursa (care poate fi un stream) */
+	if (pipeline_running) {
+		pipeline_await(PIPELINE_HEADER);
+		size = pipeline_hdr_size;
+		if (size > 0)
+			memcpy(hdr, pipeline_hdr, size);
+	} else {
+		size = source_read(source, hdr, sizeof(hdr), 0);
+	}
+	if (size < 0) {
+		perror("read");
+		return NULL;
+	}
+
+	/* imaginile impachetate (so_pack) contin deja planul de incarcare */
+	if (packed_is_image(hdr, size)) {
+		exec_key = NULL;
+		exec = packed_open(&source);
+		if (!exec)
+			return NULL;
+
+		pages_no = compute_pages_no();
+		return exec;
+	}
+
+	exec = so_parse_exec_hdr(hdr, size);
 	if (!exec)
+		return NULL;
+
+	pages_no = compute_pages_no();
+	if (exec_key)
+		plan_cache_store(exec_key, exec, pages_no);
+
+	return exec;
+}
+
+int so_execute(char *path, char *argv[])
+{
+	uint64_t start_ns;
+	int fd, i;
+
+	/* fiecare incercare a autotuner-ului continua executia de aici */
+	if (so_cfg.autotune)
+		tune_run(path);
+
+	if (so_cfg.stats)
+		stats_watch();
+	start_ns = stats_now();
+
+	if (so_cfg.trace && trace_open(so_cfg.trace) < 0)
+		perror("trace");
+
+	/*
+	 * deschidem sursa executabilului pentru a putea citi ulterior
+	 * datele paginilor din ea
+	 */
+	source = source_open(path);
+	if (!source)
 		return -1;
 
+	/* cu eager, toate paginile sunt oricum mapate inainte de salt */
+	if (so_cfg.pipeline && !so_cfg.eager)
+		pipeline_start();
+
+	exec = load_plan();
+	if (!exec) {
+		pipeline_cancel();
+		return -1;
+	}
+
+	/* configuratia aleasa anterior de autotuner pentru acest executabil */
+	if (exec_key)
+		tune_apply(exec_key);
+
+	if (so_cfg.io_mode == IO_MMAP && source_map(source, exec) < 0)
+		so_cfg.io_mode = IO_READ;
+	pipeline_post(PIPELINE_PLAN);
+
+	/* optiunile de mai jos au nevoie de acces direct la fisier */
+	fd = source->fd;
+	if (fd < 0 && (so_cfg.zero_index || so_cfg.perf_map ||
+		       so_cfg.gdb_jit || so_cfg.prefault))
+		fprintf(stderr, "so_loader: %s is not a regular file, "
+			"file based options are ignored\n", path);
+
+	if (so_cfg.zero_index && fd >= 0)
+		zero_index_build(exec, pages_no, fd, exec_key);
+
 	/*
-	 * deschidem fisierul executabil pentru a putea citi ulterior
-	 * datele paginilor din el
+	 * fara manifest valid nu putem garanta integritatea paginilor; el
+	 * poate fi folosit cu orice sursa a carei dimensiune este cunoscuta
 	 */
-	file_descriptor = open(path, O_RDONLY);
-	DIE(file_descriptor < 0, "open failed.");
+	if (so_cfg.manifest) {
+		if (source->size < 0 ||
+		    manifest_load(so_cfg.manifest, exec, pages_no,
+				  source->size) < 0) {
+			fprintf(stderr, "invalid manifest %s\n", so_cfg.manifest);
+			pipeline_cancel();
+			return -1;
+		}
+	}
+
+	numa_init(exec);
+
+	/* calculele facute pana acum la fiecare page fault */
+	actions = actions_compile(exec, so_cfg.zero_index);
+
+	/*
+	 * vectorii de stare sunt alocati inainte ca alte thread-uri (eager,
+	 * pornirea in paralel, indicii) sa poata revendica pagini
+	 */
+	for (i = 0; i < exec->segments_no; i++)
+		page_states(i);
+	if (so_cfg.footprint)
+		footprint_init();
+
+	/* paginile din pool nu pot fi plasate conform politicii NUMA */
+	if (so_cfg.pool && so_cfg.numa) {
+		fprintf(stderr, "so_loader: SO_LOADER_POOL is ignored when "
+			"SO_LOADER_NUMA is set\n");
+		so_cfg.pool = 0;
+	}
+	if (so_cfg.pool)
+		pool_init(so_cfg.pool);
+
+	if (so_cfg.reserve)
+		reserve_segments();
+
+	if (so_cfg.eager)
+		for (i = 0; i < exec->segments_no; i++)
+			populate_segment(i);
+	pipeline_post(PIPELINE_READY);
+
+	/* exportam simbolurile programului pentru perf si GDB */
+	if (so_cfg.perf_map && fd >= 0)
+		symexport_perf_map(fd);
+	if (so_cfg.gdb_jit && fd >= 0)
+		symexport_gdb_jit(fd);
+
+	/* mapam in avans paginile de cod necesare, probabil, la pornire */
+	if (so_cfg.prefault && fd >= 0) {
+		uintptr_t *pages;
+		int count;
+
+		/* analiza se suprapune cu aducerea primelor pagini */
+		count = reach_analyze(exec, fd, exec_key, &pages);
+		prefault_pages(pages, count);
+		free(pages);
+	}
+
+	/* pagina prin care programul cere popularea sau eliberarea zonelor */
+	if (so_cfg.hints)
+		hint_start();
+
+	if (so_stats)
+		so_stats->entry_ns = stats_now() - start_ns;
+
+	if (so_cfg.footprint)
+		footprint_start(exec, pages_no);
+
+	/* doar executia programului este masurata de contoarele perf */
+	if (so_cfg.perf)
+		perf_before_jump();
+
+	if (so_cfg.trace)
+		trace_mark_entry();
 
 	so_start_exec(exec, argv);
 
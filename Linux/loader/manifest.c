@@ -0,0 +1,84 @@
+/*
+ * Per-page integrity manifest
+ *
+ * 2018, Operating Systems
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+
+#include "manifest.h"
+#include "crc32c.h"
+#include "utils.h"
+
+/* digest-urile paginilor fiecarui segment (pointeaza in maparea fisierului) */
+static uint32_t **seg_digests;
+
+int manifest_load(const char *path, so_exec_t *exec,
+		  const unsigned int *pages_no, off_t file_size)
+{
+	struct manifest_hdr *hdr;
+	struct stat st;
+	uint32_t *p, *end;
+	void *map;
+	int fd, i;
+
+	fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return -1;
+
+	if (fstat(fd, &st) < 0 || st.st_size < (off_t)sizeof(*hdr)) {
+		close(fd);
+		return -1;
+	}
+
+	map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED)
+		return -1;
+
+	hdr = map;
+	if (hdr->magic != MANIFEST_MAGIC || hdr->version != MANIFEST_VERSION ||
+	    hdr->hdr_size != sizeof(*hdr) ||
+	    hdr->page_size != (uint32_t)getpagesize() ||
+	    hdr->segments_no != (uint32_t)exec->segments_no ||
+	    hdr->file_size != (uint64_t)file_size)
+		goto out_unmap;
+
+	seg_digests = calloc(exec->segments_no, sizeof(uint32_t *));
+	DIE(!seg_digests, "calloc failed.");
+
+	p = (uint32_t *)(hdr + 1);
+	end = (uint32_t *)((char *)map + st.st_size);
+	for (i = 0; i < exec->segments_no; i++) {
+		if (p >= end || *p != pages_no[i] || end - p - 1 < *p)
+			goto out_free;
+		seg_digests[i] = p + 1;
+		p += 1 + pages_no[i];
+	}
+
+	crc32c_init();
+	return 0;
+
+out_free:
+	free(seg_digests);
+	seg_digests = NULL;
+out_unmap:
+	munmap(map, st.st_size);
+	return -1;
+}
+
+int manifest_enabled(void)
+{
+	return seg_digests != NULL;
+}
+
+int manifest_verify(int seg_index, int page_index, const void *page)
+{
+	return crc32c(page, getpagesize()) ==
+		seg_digests[seg_index][page_index] ? 0 : -1;
+}
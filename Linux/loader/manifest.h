@@ -0,0 +1,45 @@
+/*
+ * Per-page integrity manifest
+ *
+ * 2018, Operating Systems
+ */
+
+#ifndef SO_MANIFEST_H_
+#define SO_MANIFEST_H_
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "exec_parser.h"
+
+#define MANIFEST_MAGIC		0x464d4f53	/* "SOMF" */
+#define MANIFEST_VERSION	1
+
+/*
+ * antetul manifestului; este urmat, pentru fiecare segment, de numarul de
+ * pagini (uint32_t) si de digest-urile CRC32C ale paginilor (uint32_t),
+ * calculate pe continutul paginii asa cum este mapata de loader
+ */
+struct manifest_hdr {
+	uint32_t magic;
+	uint16_t version;
+	uint16_t hdr_size;
+	uint32_t page_size;
+	uint32_t segments_no;
+	uint64_t file_size;
+};
+
+/*
+ * incarca manifestul de la path si verifica daca descrie executabilul
+ * (aceleasi segmente, pagini si dimensiune a fisierului); intoarce 0 sau -1
+ */
+int manifest_load(const char *path, so_exec_t *exec,
+		  const unsigned int *pages_no, off_t file_size);
+
+/* intoarce 1 daca a fost incarcat un manifest */
+int manifest_enabled(void);
+
+/* verifica pagina page_index din segmentul seg_index; intoarce 0 sau -1 */
+int manifest_verify(int seg_index, int page_index, const void *page);
+
+#endif /* SO_MANIFEST_H_ */
@@ -0,0 +1,279 @@
+/*
+ * NUMA placement of demand-loaded pages
+ *
+ * 2018, Operating Systems
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#include "numa.h"
+#include "config.h"
+#include "stats.h"
+#include "utils.h"
+
+/* valorile din <numaif.h> (nu depindem de libnuma) */
+#define MPOL_PREFERRED	1
+#define MPOL_BIND	2
+#define MPOL_INTERLEAVE	3
+#define MPOL_LOCAL	4
+#define MPOL_F_NODE	(1 << 0)
+#define MPOL_F_ADDR	(1 << 1)
+
+#define BITS_PER_LONG	(8 * sizeof(unsigned long))
+#define MASK_LONGS	(NUMA_MAX_NODES / BITS_PER_LONG)
+
+struct seg_numa {
+	enum numa_policy policy;
+	unsigned long nodes[MASK_LONGS];
+};
+
+/* politica fiecarui segment */
+static struct seg_numa *seg_policy;
+
+/* masca nodurilor online si numarul lor */
+static unsigned long online[MASK_LONGS];
+static int nodes_no;
+
+/*
+ * interpreteaza o lista de noduri de forma "0,2-3"; intoarce -1 daca
+ * lista e invalida
+ */
+static int parse_nodes(const char *str, unsigned long *mask)
+{
+	char *end;
+	long first, last;
+
+	memset(mask, 0, MASK_LONGS * sizeof(unsigned long));
+	while (*str) {
+		first = strtol(str, &end, 10);
+		last = first;
+		if (end == str)
+			return -1;
+		if (*end == '-') {
+			str = end + 1;
+			last = strtol(str, &end, 10);
+			if (end == str)
+				return -1;
+		}
+		if (first < 0 || last < first || last >= NUMA_MAX_NODES)
+			return -1;
+
+		for (; first <= last; first++)
+			mask[first / BITS_PER_LONG] |=
+				1ul << (first % BITS_PER_LONG);
+
+		if (*end != ',' && *end != '\0')
+			return -1;
+		str = *end ? end + 1 : end;
+	}
+
+	return 0;
+}
+
+/* interpreteaza o politica: local, interleave[:noduri] sau bind:noduri */
+static int parse_policy(const char *str, struct seg_numa *result)
+{
+	const char *nodes = strchr(str, ':');
+	size_t len = nodes ? (size_t)(nodes - str) : strlen(str);
+
+	memcpy(result->nodes, online, sizeof(online));
+
+	if (len == 5 && !strncmp(str, "local", len) && !nodes) {
+		result->policy = NUMA_LOCAL;
+	} else if (len == 10 && !strncmp(str, "interleave", len)) {
+		result->policy = NUMA_INTERLEAVE;
+	} else if (len == 4 && !strncmp(str, "bind", len) && nodes) {
+		result->policy = NUMA_BIND;
+	} else {
+		return -1;
+	}
+
+	if (nodes && parse_nodes(nodes + 1, result->nodes) < 0)
+		return -1;
+
+	return 0;
+}
+
+/* citeste nodurile online din sysfs (implicit, doar nodul 0) */
+static void read_online_nodes(void)
+{
+	char buf[256];
+	FILE *file;
+	int i;
+
+	online[0] = 1;
+	file = fopen("/sys/devices/system/node/online", "r");
+	if (file) {
+		if (fgets(buf, sizeof(buf), file)) {
+			buf[strcspn(buf, "\n")] = '\0';
+			if (parse_nodes(buf, online) < 0) {
+				memset(online, 0, sizeof(online));
+				online[0] = 1;
+			}
+		}
+		fclose(file);
+	}
+
+	nodes_no = 0;
+	for (i = 0; i < NUMA_MAX_NODES; i++)
+		if (online[i / BITS_PER_LONG] & (1ul << (i % BITS_PER_LONG)))
+			nodes_no++;
+}
+
+/* aplica politica pe zona [addr, addr + len); intoarce rezultatul mbind */
+static long apply_policy(struct seg_numa *numa, void *addr, size_t len)
+{
+	long ret = 0;
+
+	switch (numa->policy) {
+	case NUMA_DEFAULT:
+		break;
+	case NUMA_LOCAL:
+		ret = syscall(SYS_mbind, addr, len, MPOL_LOCAL, NULL, 0, 0);
+		/* kernel-urile vechi: MPOL_PREFERRED cu masca vida */
+		if (ret < 0 && errno == EINVAL)
+			ret = syscall(SYS_mbind, addr, len, MPOL_PREFERRED,
+				      NULL, 0, 0);
+		break;
+	case NUMA_INTERLEAVE:
+		ret = syscall(SYS_mbind, addr, len, MPOL_INTERLEAVE,
+			      numa->nodes, NUMA_MAX_NODES + 1, 0);
+		break;
+	case NUMA_BIND:
+		ret = syscall(SYS_mbind, addr, len, MPOL_BIND,
+			      numa->nodes, NUMA_MAX_NODES + 1, 0);
+		break;
+	}
+
+	return ret;
+}
+
+/*
+ * verifica politica segmentului inainte de salt: nodurile trebuie sa fie
+ * online, iar kernel-ul trebuie sa accepte politica (incercata pe o
+ * pagina temporara); intoarce -1 daca politica nu poate fi aplicata
+ */
+static int check_policy(struct seg_numa *numa)
+{
+	void *page;
+	long ret;
+	int i, any = 0;
+
+	if (numa->policy == NUMA_DEFAULT || numa->policy == NUMA_LOCAL)
+		goto probe;
+
+	for (i = 0; i < (int)MASK_LONGS; i++) {
+		if (numa->nodes[i] & ~online[i])
+			return -1;
+		any |= numa->nodes[i] != 0;
+	}
+	if (!any)
+		return -1;
+
+probe:
+	if (nodes_no < 2)
+		return 0;
+
+	page = mmap(NULL, getpagesize(), PROT_READ | PROT_WRITE,
+		    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (page == MAP_FAILED)
+		return -1;
+	ret = apply_policy(numa, page, getpagesize());
+	munmap(page, getpagesize());
+
+	return ret < 0 ? -1 : 0;
+}
+
+void numa_init(so_exec_t *exec)
+{
+	char *spec, *item, *policy, *save, *end;
+	long seg;
+	int i;
+
+	read_online_nodes();
+	if (!so_cfg.numa)
+		return;
+
+	seg_policy = calloc(exec->segments_no, sizeof(*seg_policy));
+	DIE(!seg_policy, "calloc failed.");
+
+	spec = strdup(so_cfg.numa);
+	DIE(!spec, "strdup failed.");
+
+	/* elementele sunt de forma [segment=]politica, separate prin ';' */
+	for (item = strtok_r(spec, ";", &save); item;
+	     item = strtok_r(NULL, ";", &save)) {
+		policy = strchr(item, '=');
+		seg = -1;
+		if (policy) {
+			seg = strtol(item, &end, 10);
+			if (end != policy || seg < 0 || seg >= exec->segments_no)
+				goto invalid;
+			policy++;
+		} else {
+			policy = item;
+		}
+
+		for (i = 0; i < exec->segments_no; i++) {
+			if (seg >= 0 && i != seg)
+				continue;
+			if (parse_policy(policy, &seg_policy[i]) < 0)
+				goto invalid;
+		}
+	}
+
+	/* politicile inaplicabile nu trebuie sa opreasca programul la fault */
+	for (i = 0; i < exec->segments_no; i++) {
+		if (check_policy(&seg_policy[i]) < 0) {
+			fprintf(stderr, "so_loader: SO_LOADER_NUMA policy of "
+				"segment %d cannot be applied, using the "
+				"default policy\n", i);
+			seg_policy[i].policy = NUMA_DEFAULT;
+		}
+	}
+
+	free(spec);
+	return;
+
+invalid:
+	fprintf(stderr, "so_loader: invalid SO_LOADER_NUMA item '%s', "
+		"SO_LOADER_NUMA is ignored\n", item);
+	free(spec);
+	free(seg_policy);
+	seg_policy = NULL;
+	so_cfg.numa = NULL;
+}
+
+/*
+ * politicile au fost verificate in numa_init; daca mbind esueaza totusi,
+ * pagina ramane cu politica implicita (suntem, de obicei, in handler)
+ */
+void numa_place(int seg_index, void *addr, size_t len)
+{
+	if (!seg_policy || nodes_no < 2)
+		return;
+
+	apply_policy(&seg_policy[seg_index], addr, len);
+}
+
+void numa_account(void *addr)
+{
+	int node = 0;
+
+	if (!so_stats)
+		return;
+
+	if (nodes_no > 1 &&
+	    syscall(SYS_get_mempolicy, &node, NULL, 0, addr,
+		    MPOL_F_NODE | MPOL_F_ADDR) < 0)
+		return;
+
+	if (node >= 0 && node < NUMA_MAX_NODES)
+		STATS_ADD(numa_pages[node], 1);
+}
@@ -0,0 +1,41 @@
+/*
+ * NUMA placement of demand-loaded pages
+ *
+ * 2018, Operating Systems
+ */
+
+#ifndef SO_NUMA_H_
+#define SO_NUMA_H_
+
+#include <stddef.h>
+
+#include "exec_parser.h"
+
+/* numarul maxim de noduri suportate */
+#define NUMA_MAX_NODES	64
+
+/* politica de plasare a paginilor unui segment */
+enum numa_policy {
+	/* politica procesului (nodul thread-ului care acceseaza pagina) */
+	NUMA_DEFAULT,
+	/* explicit pe nodul local */
+	NUMA_LOCAL,
+	/* paginile sunt distribuite round-robin pe multimea de noduri */
+	NUMA_INTERLEAVE,
+	/* paginile sunt alocate doar pe multimea de noduri */
+	NUMA_BIND,
+};
+
+/*
+ * interpreteaza SO_LOADER_NUMA pentru segmentele executabilului; pe
+ * masinile cu un singur nod politicile sunt validate, dar nu se aplica
+ */
+void numa_init(so_exec_t *exec);
+
+/* aplica politica segmentului pe o zona abia mapata (inainte de acces) */
+void numa_place(int seg_index, void *addr, size_t len);
+
+/* contorizeaza (in statistici) nodul pe care se afla pagina de la addr */
+void numa_account(void *addr);
+
+#endif /* SO_NUMA_H_ */
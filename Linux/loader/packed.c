@@ -0,0 +1,177 @@
+/*
+ * Loader-optimised packed image format
+ *
+ * 2018, Operating Systems
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <stdint.h>
+
+#include "packed.h"
+#include "page_ops.h"
+#include "utils.h"
+
+struct packed {
+	/* sursa din care este citita imaginea */
+	struct so_source *under;
+	struct packed_hdr hdr;
+	uint32_t *dir;
+	/* paginile calde, citite la deschidere */
+	char *hot;
+};
+
+int packed_is_image(const char *hdr, int size)
+{
+	uint32_t magic;
+
+	if (size < (int)sizeof(struct packed_hdr))
+		return 0;
+
+	memcpy(&magic, hdr, sizeof(magic));
+	return magic == PACKED_MAGIC;
+}
+
+/* citeste len bytes de la offset-ul off din executabilul original */
+static ssize_t packed_read(struct so_source *src, void *buf, size_t len,
+			   off_t offset)
+{
+	struct packed *packed = src->priv;
+	size_t page_size = packed->hdr.page_size;
+	size_t done = 0, page, in_page, chunk;
+	uint32_t slot;
+	off_t where;
+
+	while (done < len) {
+		page = (offset + done) / page_size;
+		in_page = (offset + done) % page_size;
+		if (page >= packed->hdr.file_pages)
+			break;
+
+		chunk = page_size - in_page;
+		if (chunk > len - done)
+			chunk = len - done;
+
+		slot = packed->dir[page];
+		if (slot == PACKED_NONE) {
+			page_zero((char *)buf + done, chunk);
+		} else if (slot < packed->hdr.hot_pages) {
+			page_copy((char *)buf + done,
+				  packed->hot + slot * page_size + in_page,
+				  chunk);
+		} else {
+			where = packed->hdr.data_offset +
+				(off_t)slot * page_size + in_page;
+			if (source_read(packed->under, (char *)buf + done,
+					chunk, where) != (ssize_t)chunk)
+				return -1;
+		}
+
+		done += chunk;
+	}
+
+	return done;
+}
+
+so_exec_t *packed_open(struct so_source **src)
+{
+	struct so_source *under = *src, *new_src;
+	struct packed *packed;
+	struct packed_seg *segs = NULL;
+	so_exec_t *exec = NULL;
+	const char *err = "invalid";
+	uint64_t len64;
+	size_t len;
+	uint32_t i;
+
+	packed = calloc(1, sizeof(*packed));
+	DIE(!packed, "calloc failed.");
+	packed->under = under;
+
+	if (source_read(under, &packed->hdr, sizeof(packed->hdr), 0) !=
+	    sizeof(packed->hdr) || packed->hdr.magic != PACKED_MAGIC ||
+	    packed->hdr.version != PACKED_VERSION ||
+	    packed->hdr.hdr_size != sizeof(packed->hdr) ||
+	    packed->hdr.page_size != (uint32_t)getpagesize() ||
+	    packed->hdr.hot_pages > packed->hdr.data_pages)
+		goto out_invalid;
+
+	/*
+	 * planul de incarcare si directorul urmeaza imediat dupa antet;
+	 * dimensiunile sunt verificate pentru a nu depasi size_t (32 de biti)
+	 */
+	len64 = (uint64_t)packed->hdr.segments_no * sizeof(*segs) +
+		(uint64_t)packed->hdr.file_pages * sizeof(*packed->dir);
+	if (len64 > SIZE_MAX || (uint64_t)packed->hdr.hot_pages *
+	    packed->hdr.page_size > SIZE_MAX)
+		goto out_invalid;
+	len = len64;
+	segs = malloc(len);
+	DIE(!segs, "malloc failed.");
+	err = "truncated";
+	if (source_read(under, segs, len, sizeof(packed->hdr)) !=
+	    (ssize_t)len)
+		goto out_invalid;
+	packed->dir = (uint32_t *)(segs + packed->hdr.segments_no);
+
+	/* un index gresit ar servi alte pagini ale imaginii */
+	err = "invalid";
+	for (i = 0; i < packed->hdr.file_pages; i++)
+		if (packed->dir[i] != PACKED_NONE &&
+		    packed->dir[i] >= packed->hdr.data_pages)
+			goto out_invalid;
+
+	exec = malloc(sizeof(*exec));
+	DIE(!exec, "malloc failed.");
+	exec->base_addr = packed->hdr.base_addr;
+	exec->entry = packed->hdr.entry;
+	exec->segments_no = packed->hdr.segments_no;
+	exec->segments = calloc(exec->segments_no, sizeof(so_seg_t));
+	DIE(!exec->segments, "calloc failed.");
+	for (i = 0; i < packed->hdr.segments_no; i++) {
+		exec->segments[i].vaddr = segs[i].vaddr;
+		exec->segments[i].file_size = segs[i].file_size;
+		exec->segments[i].mem_size = segs[i].mem_size;
+		exec->segments[i].offset = segs[i].offset;
+		exec->segments[i].perm = segs[i].perm;
+	}
+
+	/* paginile calde sunt citite secvential, cu o singura cerere */
+	if (packed->hdr.hot_pages) {
+		len = (size_t)packed->hdr.hot_pages * packed->hdr.page_size;
+		packed->hot = malloc(len);
+		DIE(!packed->hot, "malloc failed.");
+		err = "truncated";
+		if (source_read(under, packed->hot, len,
+				packed->hdr.data_offset) != (ssize_t)len)
+			goto out_invalid;
+	}
+
+	/*
+	 * offset-urile din plan sunt cele din executabilul original, deci
+	 * noua sursa nu mai este un fisier obisnuit (fd = -1)
+	 */
+	new_src = calloc(1, sizeof(*new_src));
+	DIE(!new_src, "calloc failed.");
+	new_src->read = packed_read;
+	new_src->fd = -1;
+	/* manifestul descrie executabilul original, nu imaginea */
+	new_src->size = -1;
+	new_src->priv = packed;
+	*src = new_src;
+
+	return exec;
+
+out_invalid:
+	fprintf(stderr, "so_loader: %s packed image\n", err);
+	if (exec) {
+		free(exec->segments);
+		free(exec);
+	}
+	free(packed->hot);
+	free(segs);
+	free(packed);
+	return NULL;
+}
@@ -0,0 +1,67 @@
+/*
+ * Loader-optimised packed image format
+ *
+ * 2018, Operating Systems
+ */
+
+#ifndef SO_PACKED_H_
+#define SO_PACKED_H_
+
+#include <stdint.h>
+
+#include "exec_parser.h"
+#include "source.h"
+
+#define PACKED_MAGIC	0x4b504f53	/* "SOPK" */
+#define PACKED_VERSION	1
+
+/* intrare de director pentru o pagina nestocata (doar zerouri) */
+#define PACKED_NONE	0xffffffffu
+
+/*
+ * o imagine impachetata contine, in ordine:
+ *	struct packed_hdr
+ *	struct packed_seg[segments_no]	planul de incarcare
+ *	uint32_t dir[file_pages]	pentru fiecare pagina din executabilul
+ *					original, indexul ei in zona de date
+ *					sau PACKED_NONE
+ *	zona de date (de la data_offset, aliniata la pagina): paginile, cu
+ *	primele hot_pages fiind cele accesate la pornire, in ordinea accesului
+ */
+struct packed_hdr {
+	uint32_t magic;
+	uint16_t version;
+	uint16_t hdr_size;
+	uint32_t page_size;
+	uint32_t segments_no;
+	uint64_t entry;
+	uint64_t base_addr;
+	/* numarul de pagini ale executabilului original */
+	uint32_t file_pages;
+	/* numarul de pagini stocate si numarul celor "calde" */
+	uint32_t data_pages;
+	uint32_t hot_pages;
+	uint32_t reserved;
+	uint64_t data_offset;
+};
+
+struct packed_seg {
+	uint64_t vaddr;
+	uint32_t file_size;
+	uint32_t mem_size;
+	/* offset-ul in executabilul original */
+	uint32_t offset;
+	uint32_t perm;
+};
+
+/* intoarce 1 daca primii bytes ai sursei sunt antetul unei imagini */
+int packed_is_image(const char *hdr, int size);
+
+/*
+ * citeste planul de incarcare al imaginii si inlocuieste *src cu o sursa
+ * care traduce offset-urile din executabilul original in pagini ale
+ * imaginii; paginile calde sunt citite cu o singura citire secventiala
+ */
+so_exec_t *packed_open(struct so_source **src);
+
+#endif /* SO_PACKED_H_ */
@@ -0,0 +1,315 @@
+/*
+ * Page fill and copy kernels
+ *
+ * 2018, Operating Systems
+ */
+
+#include <string.h>
+#include <stdint.h>
+#if defined(__i386__) || defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+#include "page_ops.h"
+
+static void zero_generic(void *dst, size_t len)
+{
+	memset(dst, 0, len);
+}
+
+static void copy_generic(void *dst, const void *src, size_t len)
+{
+	memcpy(dst, src, len);
+}
+
+static const struct page_ops ops_generic = {
+	"generic", zero_generic, copy_generic, zero_generic, copy_generic
+};
+
+struct page_ops so_page_ops = {
+	"generic", zero_generic, copy_generic, zero_generic, copy_generic
+};
+
+#if defined(__i386__) || defined(__x86_64__)
+
+/*
+ * numarul de bytes pana la urmatoarea adresa aliniata la align (scrierile
+ * non-temporale cer destinatii aliniate)
+ */
+static size_t head_len(const void *dst, size_t align, size_t len)
+{
+	size_t head = (align - ((uintptr_t)dst & (align - 1))) & (align - 1);
+
+	return head < len ? head : len;
+}
+
+__attribute__((target("sse2")))
+static void zero_sse2(void *dst, size_t len)
+{
+	char *d = dst;
+	__m128i zero = _mm_setzero_si128();
+
+	for (; len >= 64; len -= 64, d += 64) {
+		_mm_storeu_si128((__m128i *)d, zero);
+		_mm_storeu_si128((__m128i *)(d + 16), zero);
+		_mm_storeu_si128((__m128i *)(d + 32), zero);
+		_mm_storeu_si128((__m128i *)(d + 48), zero);
+	}
+	memset(d, 0, len);
+}
+
+__attribute__((target("sse2")))
+static void copy_sse2(void *dst, const void *src, size_t len)
+{
+	char *d = dst;
+	const char *s = src;
+	__m128i a, b, c, e;
+
+	for (; len >= 64; len -= 64, d += 64, s += 64) {
+		a = _mm_loadu_si128((const __m128i *)s);
+		b = _mm_loadu_si128((const __m128i *)(s + 16));
+		c = _mm_loadu_si128((const __m128i *)(s + 32));
+		e = _mm_loadu_si128((const __m128i *)(s + 48));
+		_mm_storeu_si128((__m128i *)d, a);
+		_mm_storeu_si128((__m128i *)(d + 16), b);
+		_mm_storeu_si128((__m128i *)(d + 32), c);
+		_mm_storeu_si128((__m128i *)(d + 48), e);
+	}
+	memcpy(d, s, len);
+}
+
+__attribute__((target("sse2")))
+static void zero_nt_sse2(void *dst, size_t len)
+{
+	size_t head = head_len(dst, 16, len);
+	char *d = (char *)dst + head;
+	__m128i zero = _mm_setzero_si128();
+
+	memset(dst, 0, head);
+	for (len -= head; len >= 64; len -= 64, d += 64) {
+		_mm_stream_si128((__m128i *)d, zero);
+		_mm_stream_si128((__m128i *)(d + 16), zero);
+		_mm_stream_si128((__m128i *)(d + 32), zero);
+		_mm_stream_si128((__m128i *)(d + 48), zero);
+	}
+	_mm_sfence();
+	memset(d, 0, len);
+}
+
+__attribute__((target("sse2")))
+static void copy_nt_sse2(void *dst, const void *src, size_t len)
+{
+	size_t head = head_len(dst, 16, len);
+	char *d = (char *)dst + head;
+	const char *s = (const char *)src + head;
+	__m128i a, b, c, e;
+
+	memcpy(dst, src, head);
+	for (len -= head; len >= 64; len -= 64, d += 64, s += 64) {
+		a = _mm_loadu_si128((const __m128i *)s);
+		b = _mm_loadu_si128((const __m128i *)(s + 16));
+		c = _mm_loadu_si128((const __m128i *)(s + 32));
+		e = _mm_loadu_si128((const __m128i *)(s + 48));
+		_mm_stream_si128((__m128i *)d, a);
+		_mm_stream_si128((__m128i *)(d + 16), b);
+		_mm_stream_si128((__m128i *)(d + 32), c);
+		_mm_stream_si128((__m128i *)(d + 48), e);
+	}
+	_mm_sfence();
+	memcpy(d, s, len);
+}
+
+__attribute__((target("avx2")))
+static void zero_avx2(void *dst, size_t len)
+{
+	char *d = dst;
+	__m256i zero = _mm256_setzero_si256();
+
+	for (; len >= 128; len -= 128, d += 128) {
+		_mm256_storeu_si256((__m256i *)d, zero);
+		_mm256_storeu_si256((__m256i *)(d + 32), zero);
+		_mm256_storeu_si256((__m256i *)(d + 64), zero);
+		_mm256_storeu_si256((__m256i *)(d + 96), zero);
+	}
+	memset(d, 0, len);
+}
+
+__attribute__((target("avx2")))
+static void copy_avx2(void *dst, const void *src, size_t len)
+{
+	char *d = dst;
+	const char *s = src;
+	__m256i a, b, c, e;
+
+	for (; len >= 128; len -= 128, d += 128, s += 128) {
+		a = _mm256_loadu_si256((const __m256i *)s);
+		b = _mm256_loadu_si256((const __m256i *)(s + 32));
+		c = _mm256_loadu_si256((const __m256i *)(s + 64));
+		e = _mm256_loadu_si256((const __m256i *)(s + 96));
+		_mm256_storeu_si256((__m256i *)d, a);
+		_mm256_storeu_si256((__m256i *)(d + 32), b);
+		_mm256_storeu_si256((__m256i *)(d + 64), c);
+		_mm256_storeu_si256((__m256i *)(d + 96), e);
+	}
+	memcpy(d, s, len);
+}
+
+__attribute__((target("avx2")))
+static void zero_nt_avx2(void *dst, size_t len)
+{
+	size_t head = head_len(dst, 32, len);
+	char *d = (char *)dst + head;
+	__m256i zero = _mm256_setzero_si256();
+
+	memset(dst, 0, head);
+	for (len -= head; len >= 128; len -= 128, d += 128) {
+		_mm256_stream_si256((__m256i *)d, zero);
+		_mm256_stream_si256((__m256i *)(d + 32), zero);
+		_mm256_stream_si256((__m256i *)(d + 64), zero);
+		_mm256_stream_si256((__m256i *)(d + 96), zero);
+	}
+	_mm_sfence();
+	memset(d, 0, len);
+}
+
+__attribute__((target("avx2")))
+static void copy_nt_avx2(void *dst, const void *src, size_t len)
+{
+	size_t head = head_len(dst, 32, len);
+	char *d = (char *)dst + head;
+	const char *s = (const char *)src + head;
+	__m256i a, b, c, e;
+
+	memcpy(dst, src, head);
+	for (len -= head; len >= 128; len -= 128, d += 128, s += 128) {
+		a = _mm256_loadu_si256((const __m256i *)s);
+		b = _mm256_loadu_si256((const __m256i *)(s + 32));
+		c = _mm256_loadu_si256((const __m256i *)(s + 64));
+		e = _mm256_loadu_si256((const __m256i *)(s + 96));
+		_mm256_stream_si256((__m256i *)d, a);
+		_mm256_stream_si256((__m256i *)(d + 32), b);
+		_mm256_stream_si256((__m256i *)(d + 64), c);
+		_mm256_stream_si256((__m256i *)(d + 96), e);
+	}
+	_mm_sfence();
+	memcpy(d, s, len);
+}
+
+__attribute__((target("avx512f")))
+static void zero_avx512(void *dst, size_t len)
+{
+	char *d = dst;
+	__m512i zero = _mm512_setzero_si512();
+
+	for (; len >= 256; len -= 256, d += 256) {
+		_mm512_storeu_si512(d, zero);
+		_mm512_storeu_si512(d + 64, zero);
+		_mm512_storeu_si512(d + 128, zero);
+		_mm512_storeu_si512(d + 192, zero);
+	}
+	memset(d, 0, len);
+}
+
+__attribute__((target("avx512f")))
+static void copy_avx512(void *dst, const void *src, size_t len)
+{
+	char *d = dst;
+	const char *s = src;
+	__m512i a, b, c, e;
+
+	for (; len >= 256; len -= 256, d += 256, s += 256) {
+		a = _mm512_loadu_si512(s);
+		b = _mm512_loadu_si512(s + 64);
+		c = _mm512_loadu_si512(s + 128);
+		e = _mm512_loadu_si512(s + 192);
+		_mm512_storeu_si512(d, a);
+		_mm512_storeu_si512(d + 64, b);
+		_mm512_storeu_si512(d + 128, c);
+		_mm512_storeu_si512(d + 192, e);
+	}
+	memcpy(d, s, len);
+}
+
+__attribute__((target("avx512f")))
+static void zero_nt_avx512(void *dst, size_t len)
+{
+	size_t head = head_len(dst, 64, len);
+	char *d = (char *)dst + head;
+	__m512i zero = _mm512_setzero_si512();
+
+	memset(dst, 0, head);
+	for (len -= head; len >= 256; len -= 256, d += 256) {
+		_mm512_stream_si512((void *)d, zero);
+		_mm512_stream_si512((void *)(d + 64), zero);
+		_mm512_stream_si512((void *)(d + 128), zero);
+		_mm512_stream_si512((void *)(d + 192), zero);
+	}
+	_mm_sfence();
+	memset(d, 0, len);
+}
+
+__attribute__((target("avx512f")))
+static void copy_nt_avx512(void *dst, const void *src, size_t len)
+{
+	size_t head = head_len(dst, 64, len);
+	char *d = (char *)dst + head;
+	const char *s = (const char *)src + head;
+	__m512i a, b, c, e;
+
+	memcpy(dst, src, head);
+	for (len -= head; len >= 256; len -= 256, d += 256, s += 256) {
+		a = _mm512_loadu_si512(s);
+		b = _mm512_loadu_si512(s + 64);
+		c = _mm512_loadu_si512(s + 128);
+		e = _mm512_loadu_si512(s + 192);
+		_mm512_stream_si512((void *)d, a);
+		_mm512_stream_si512((void *)(d + 64), b);
+		_mm512_stream_si512((void *)(d + 128), c);
+		_mm512_stream_si512((void *)(d + 192), e);
+	}
+	_mm_sfence();
+	memcpy(d, s, len);
+}
+
+static const struct page_ops ops_sse2 = {
+	"sse2", zero_sse2, copy_sse2, zero_nt_sse2, copy_nt_sse2
+};
+
+static const struct page_ops ops_avx2 = {
+	"avx2", zero_avx2, copy_avx2, zero_nt_avx2, copy_nt_avx2
+};
+
+static const struct page_ops ops_avx512 = {
+	"avx512", zero_avx512, copy_avx512, zero_nt_avx512, copy_nt_avx512
+};
+
+#endif
+
+void page_ops_init(const char *name)
+{
+	const struct page_ops *ops = &ops_generic;
+
+#if defined(__i386__) || defined(__x86_64__)
+	const struct page_ops *candidates[] = {
+		&ops_avx512, &ops_avx2, &ops_sse2
+	};
+	int supported[3];
+	unsigned int i;
+
+	__builtin_cpu_init();
+	supported[0] = __builtin_cpu_supports("avx512f");
+	supported[1] = __builtin_cpu_supports("avx2");
+	supported[2] = __builtin_cpu_supports("sse2");
+
+	for (i = 0; i < sizeof(candidates) / sizeof(candidates[0]); i++) {
+		if (name && strcmp(name, candidates[i]->name))
+			continue;
+		if (supported[i]) {
+			ops = candidates[i];
+			break;
+		}
+	}
+#endif
+
+	so_page_ops = *ops;
+}
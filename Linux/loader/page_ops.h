@@ -0,0 +1,54 @@
+/*
+ * Page fill and copy kernels
+ *
+ * 2018, Operating Systems
+ */
+
+#ifndef SO_PAGE_OPS_H_
+#define SO_PAGE_OPS_H_
+
+#include <stddef.h>
+
+/*
+ * de la aceasta dimensiune in sus copierile si zeroizarile folosesc
+ * scrieri non-temporale (incarcarile mari nu polueaza cache-ul)
+ */
+#define PAGE_OPS_NT_THRESHOLD	(256 * 1024)
+
+/* un set de rutine, specific unui set de instructiuni */
+struct page_ops {
+	const char *name;
+	void (*zero)(void *dst, size_t len);
+	void (*copy)(void *dst, const void *src, size_t len);
+	/* variantele non-temporale */
+	void (*zero_nt)(void *dst, size_t len);
+	void (*copy_nt)(void *dst, const void *src, size_t len);
+};
+
+/* rutinele alese in page_ops_init */
+extern struct page_ops so_page_ops;
+
+/*
+ * alege (o singura data, dupa CPUID) cea mai buna varianta: AVX-512,
+ * AVX2, SSE2 sau generica; name forteaza o anumita varianta
+ */
+void page_ops_init(const char *name);
+
+/* zeroieste/copiaza, cu scrieri non-temporale pentru zonele mari */
+static inline void page_zero(void *dst, size_t len)
+{
+	if (len >= PAGE_OPS_NT_THRESHOLD)
+		so_page_ops.zero_nt(dst, len);
+	else
+		so_page_ops.zero(dst, len);
+}
+
+static inline void page_copy(void *dst, const void *src, size_t len)
+{
+	if (len >= PAGE_OPS_NT_THRESHOLD)
+		so_page_ops.copy_nt(dst, src, len);
+	else
+		so_page_ops.copy(dst, src, len);
+}
+
+#endif /* SO_PAGE_OPS_H_ */
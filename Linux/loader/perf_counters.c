@@ -0,0 +1,158 @@
+/*
+ * Hardware performance counters around guest execution
+ *
+ * 2018, Operating Systems
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <stdint.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+#include "perf_counters.h"
+#include "utils.h"
+
+#define HW_CACHE_MISS(cache)						\
+	((cache) | (PERF_COUNT_HW_CACHE_OP_READ << 8) |			\
+	 (PERF_COUNT_HW_CACHE_RESULT_MISS << 16))
+
+/*
+ * un contor si, pentru evenimentele hardware care pot lipsi (de exemplu
+ * intr-o masina virtuala), evenimentul software folosit in locul lui;
+ * doar ciclurile au un echivalent software (cpu-clock), instructiunile si
+ * TLB miss-urile nu pot fi numarate fara PMU
+ */
+struct perf_counter {
+	const char *name;
+	uint32_t type;
+	uint64_t config;
+	const char *fallback_name;
+	uint64_t fallback_config;
+	int fd;
+	/* numele evenimentului efectiv deschis */
+	const char *opened;
+};
+
+static struct perf_counter counters[] = {
+	{ "cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES,
+	  "cpu-clock-ns", PERF_COUNT_SW_CPU_CLOCK, -1, NULL },
+	{ "instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS,
+	  NULL, 0, -1, NULL },
+	{ "dTLB-misses", PERF_TYPE_HW_CACHE,
+	  HW_CACHE_MISS(PERF_COUNT_HW_CACHE_DTLB), NULL, 0, -1, NULL },
+	{ "iTLB-misses", PERF_TYPE_HW_CACHE,
+	  HW_CACHE_MISS(PERF_COUNT_HW_CACHE_ITLB), NULL, 0, -1, NULL },
+	{ "minor-faults", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS_MIN,
+	  NULL, 0, -1, NULL },
+	{ "major-faults", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS_MAJ,
+	  NULL, 0, -1, NULL },
+	{ "context-switches", PERF_TYPE_SOFTWARE,
+	  PERF_COUNT_SW_CONTEXT_SWITCHES, NULL, 0, -1, NULL },
+	{ "task-clock-ns", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK,
+	  NULL, 0, -1, NULL },
+};
+
+#define COUNTERS_NO	(sizeof(counters) / sizeof(counters[0]))
+
+/* copilul scrie in ready_fds la salt, parintele raspunde pe go_fds */
+static int ready_fds[2] = { -1, -1 };
+static int go_fds[2] = { -1, -1 };
+
+static int perf_open(uint32_t type, uint64_t config, pid_t pid)
+{
+	struct perf_event_attr attr;
+	int fd;
+
+	memset(&attr, 0, sizeof(attr));
+	attr.size = sizeof(attr);
+	attr.type = type;
+	attr.config = config;
+	attr.inherit = 1;
+
+	fd = syscall(__NR_perf_event_open, &attr, pid, -1, -1, 0);
+	if (fd < 0 && (errno == EACCES || errno == EPERM)) {
+		/* perf_event_paranoid permite doar evenimentele user */
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		fd = syscall(__NR_perf_event_open, &attr, pid, -1, -1, 0);
+	}
+
+	return fd;
+}
+
+void perf_prepare(void)
+{
+	DIE(pipe(ready_fds) < 0 || pipe(go_fds) < 0, "pipe failed.");
+}
+
+void perf_before_jump(void)
+{
+	char c = 0;
+
+	if (ready_fds[1] < 0)
+		return;
+
+	close(ready_fds[0]);
+	close(go_fds[1]);
+	if (write(ready_fds[1], &c, 1) == 1)
+		read(go_fds[0], &c, 1);
+	close(ready_fds[1]);
+	close(go_fds[0]);
+}
+
+void perf_attach(pid_t pid)
+{
+	struct perf_counter *pc;
+	unsigned int i;
+	char c;
+
+	close(ready_fds[1]);
+	close(go_fds[0]);
+
+	/* copilul s-a terminat inainte de salt */
+	if (read(ready_fds[0], &c, 1) != 1)
+		goto out;
+
+	for (i = 0; i < COUNTERS_NO; i++) {
+		pc = &counters[i];
+		pc->fd = perf_open(pc->type, pc->config, pid);
+		pc->opened = pc->name;
+		if (pc->fd < 0 && pc->fallback_name) {
+			pc->fd = perf_open(PERF_TYPE_SOFTWARE,
+					   pc->fallback_config, pid);
+			pc->opened = pc->fallback_name;
+		}
+	}
+
+	write(go_fds[1], &c, 1);
+out:
+	close(ready_fds[0]);
+	close(go_fds[1]);
+}
+
+void perf_report(void)
+{
+	uint64_t value;
+	unsigned int i;
+
+	for (i = 0; i < COUNTERS_NO; i++) {
+		if (counters[i].fd < 0 ||
+		    read(counters[i].fd, &value, sizeof(value)) !=
+		    sizeof(value)) {
+			fprintf(stderr, "so_loader: perf %s=n/a%s\n",
+				counters[i].name,
+				counters[i].type == PERF_TYPE_SOFTWARE ||
+				counters[i].fallback_name ? "" :
+				" (no software equivalent)");
+			continue;
+		}
+
+		fprintf(stderr, "so_loader: perf %s=%llu\n",
+			counters[i].opened, (unsigned long long)value);
+		close(counters[i].fd);
+	}
+}
@@ -0,0 +1,33 @@
+/*
+ * Hardware performance counters around guest execution
+ *
+ * 2018, Operating Systems
+ */
+
+#ifndef SO_PERF_COUNTERS_H_
+#define SO_PERF_COUNTERS_H_
+
+#include <sys/types.h>
+
+/*
+ * creeaza canalele prin care procesul copil anunta saltul la entry point;
+ * se apeleaza inainte de fork
+ */
+void perf_prepare(void);
+
+/*
+ * in procesul copil, chiar inainte de salt: anunta procesul parinte si
+ * asteapta pana cand contoarele au fost deschise
+ */
+void perf_before_jump(void);
+
+/*
+ * in procesul parinte: asteapta saltul copilului pid si deschide
+ * contoarele (hardware, cu alternative software unde lipsesc)
+ */
+void perf_attach(pid_t pid);
+
+/* afiseaza contoarele, dupa terminarea copilului */
+void perf_report(void);
+
+#endif /* SO_PERF_COUNTERS_H_ */
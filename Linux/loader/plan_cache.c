@@ -0,0 +1,240 @@
+/*
+ * On-disk load plan cache
+ *
+ * 2018, Operating Systems
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <limits.h>
+
+#include "plan_cache.h"
+#include "config.h"
+
+#define CACHE_MAGIC	0x434c4f53	/* "SOLC" */
+
+/*
+ * antetul fiecarei intrari din cache; cheia (dispozitiv, inode,
+ * dimensiune, mtime) identifica versiunea executabilului
+ */
+struct cache_hdr {
+	uint32_t magic;
+	uint16_t version;
+	uint16_t hdr_size;
+	uint32_t kind;
+	uint32_t page_size;
+	uint64_t dev;
+	uint64_t ino;
+	uint64_t size;
+	int64_t mtime_sec;
+	int64_t mtime_nsec;
+	uint64_t payload_len;
+	uint32_t checksum;
+	uint32_t reserved;
+};
+
+/* antetul planului de incarcare */
+struct plan_hdr {
+	uintptr_t base_addr;
+	uintptr_t entry;
+	uint32_t segments_no;
+	/* dimensiunea unui so_seg_t la momentul scrierii */
+	uint32_t seg_size;
+};
+
+/* FNV-1a pe 32 de biti */
+static uint32_t checksum(const void *buf, size_t len)
+{
+	const unsigned char *p = buf;
+	uint32_t hash = 2166136261u;
+
+	while (len--) {
+		hash ^= *p++;
+		hash *= 16777619u;
+	}
+
+	return hash;
+}
+
+static void fill_key(struct cache_hdr *hdr, const struct stat *st,
+		     uint32_t kind)
+{
+	memset(hdr, 0, sizeof(*hdr));
+	hdr->magic = CACHE_MAGIC;
+	hdr->version = CACHE_VERSION;
+	hdr->hdr_size = sizeof(*hdr);
+	hdr->kind = kind;
+	hdr->page_size = getpagesize();
+	hdr->dev = st->st_dev;
+	hdr->ino = st->st_ino;
+	hdr->size = st->st_size;
+	hdr->mtime_sec = st->st_mtim.tv_sec;
+	hdr->mtime_nsec = st->st_mtim.tv_nsec;
+}
+
+/* construieste calea intrarii; intoarce -1 daca cache-ul e dezactivat */
+static int blob_path(char *buf, size_t size, const struct stat *st,
+		     uint32_t kind)
+{
+	int ret;
+
+	if (!so_cfg.cache_dir)
+		return -1;
+
+	ret = snprintf(buf, size, "%s/%llx-%llx.%.4s", so_cfg.cache_dir,
+		       (unsigned long long)st->st_dev,
+		       (unsigned long long)st->st_ino, (char *)&kind);
+	if (ret < 0 || (size_t)ret >= size)
+		return -1;
+
+	return 0;
+}
+
+void *cache_blob_map(const struct stat *st, uint32_t kind, size_t *len)
+{
+	char path[PATH_MAX];
+	struct cache_hdr key, *hdr;
+	struct stat cst;
+	void *map;
+	int fd;
+
+	if (blob_path(path, sizeof(path), st, kind) < 0)
+		return NULL;
+
+	fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return NULL;
+
+	if (fstat(fd, &cst) < 0 || cst.st_size < (off_t)sizeof(*hdr)) {
+		close(fd);
+		return NULL;
+	}
+
+	map = mmap(NULL, cst.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+		   fd, 0);
+	close(fd);
+	if (map == MAP_FAILED)
+		return NULL;
+
+	/* orice nepotrivire inseamna o intrare expirata sau corupta */
+	hdr = map;
+	fill_key(&key, st, kind);
+	key.payload_len = hdr->payload_len;
+	key.checksum = hdr->checksum;
+	if (memcmp(&key, hdr, sizeof(key)) ||
+	    hdr->payload_len != cst.st_size - sizeof(*hdr) ||
+	    checksum(hdr + 1, hdr->payload_len) != hdr->checksum) {
+		munmap(map, cst.st_size);
+		return NULL;
+	}
+
+	*len = hdr->payload_len;
+	return hdr + 1;
+}
+
+void cache_blob_unmap(void *payload, size_t len)
+{
+	munmap((struct cache_hdr *)payload - 1,
+	       len + sizeof(struct cache_hdr));
+}
+
+int cache_blob_store(const struct stat *st, uint32_t kind,
+		     const void *payload, size_t len)
+{
+	char path[PATH_MAX], tmp[PATH_MAX + 16];
+	struct cache_hdr hdr;
+	int fd, ret;
+
+	if (blob_path(path, sizeof(path), st, kind) < 0)
+		return -1;
+
+	fill_key(&hdr, st, kind);
+	hdr.payload_len = len;
+	hdr.checksum = checksum(payload, len);
+
+	/* scriem intr-un fisier temporar, apoi il redenumim atomic */
+	snprintf(tmp, sizeof(tmp), "%s.%d", path, getpid());
+	fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0)
+		return -1;
+
+	ret = write(fd, &hdr, sizeof(hdr)) == sizeof(hdr) &&
+	      write(fd, payload, len) == (ssize_t)len ? 0 : -1;
+	close(fd);
+
+	if (ret == 0)
+		ret = rename(tmp, path);
+	if (ret < 0)
+		unlink(tmp);
+
+	return ret;
+}
+
+so_exec_t *plan_cache_load(const struct stat *st, unsigned int **pages_no)
+{
+	struct plan_hdr *plan;
+	so_exec_t *exec;
+	size_t len;
+
+	plan = cache_blob_map(st, CACHE_KIND_PLAN, &len);
+	if (!plan)
+		return NULL;
+
+	if (len < sizeof(*plan) || plan->seg_size != sizeof(so_seg_t) ||
+	    len != sizeof(*plan) + plan->segments_no *
+	    (sizeof(so_seg_t) + sizeof(unsigned int)))
+		goto out_unmap;
+
+	exec = malloc(sizeof(*exec));
+	if (!exec)
+		goto out_unmap;
+
+	/* tabela de segmente este folosita direct din maparea privata */
+	exec->base_addr = plan->base_addr;
+	exec->entry = plan->entry;
+	exec->segments_no = plan->segments_no;
+	exec->segments = (so_seg_t *)(plan + 1);
+	*pages_no = (unsigned int *)(exec->segments + exec->segments_no);
+
+	return exec;
+
+out_unmap:
+	cache_blob_unmap(plan, len);
+	return NULL;
+}
+
+void plan_cache_store(const struct stat *st, so_exec_t *exec,
+		      unsigned int *pages_no)
+{
+	struct plan_hdr *plan;
+	so_seg_t *segments;
+	size_t len;
+	int i;
+
+	len = sizeof(*plan) + exec->segments_no *
+	      (sizeof(so_seg_t) + sizeof(unsigned int));
+	plan = calloc(1, len);
+	if (!plan)
+		return;
+
+	plan->base_addr = exec->base_addr;
+	plan->entry = exec->entry;
+	plan->segments_no = exec->segments_no;
+	plan->seg_size = sizeof(so_seg_t);
+
+	segments = (so_seg_t *)(plan + 1);
+	memcpy(segments, exec->segments, exec->segments_no * sizeof(so_seg_t));
+	for (i = 0; i < exec->segments_no; i++)
+		segments[i].data = NULL;
+	memcpy(segments + exec->segments_no, pages_no,
+	       exec->segments_no * sizeof(unsigned int));
+
+	cache_blob_store(st, CACHE_KIND_PLAN, plan, len);
+	free(plan);
+}
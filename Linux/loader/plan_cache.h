@@ -0,0 +1,49 @@
+/*
+ * On-disk load plan cache
+ *
+ * 2018, Operating Systems
+ */
+
+#ifndef SO_PLAN_CACHE_H_
+#define SO_PLAN_CACHE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/stat.h>
+
+#include "exec_parser.h"
+
+/* versiunea formatului; se incrementeaza la orice schimbare de layout */
+#define CACHE_VERSION	2
+
+/* tipurile de intrari din cache (fourcc) */
+#define CACHE_KIND(a, b, c, d)	\
+	((uint32_t)(a) | ((uint32_t)(b) << 8) |	\
+	((uint32_t)(c) << 16) | ((uint32_t)(d) << 24))
+#define CACHE_KIND_PLAN	CACHE_KIND('p', 'l', 'a', 'n')
+
+/*
+ * mapeaza (privat, copy-on-write) intrarea de tipul kind asociata
+ * executabilului descris de st; intoarce un pointer la continut sau NULL
+ * daca intrarea lipseste, este expirata sau corupta
+ */
+void *cache_blob_map(const struct stat *st, uint32_t kind, size_t *len);
+
+/* elibereaza o intrare intoarsa de cache_blob_map */
+void cache_blob_unmap(void *payload, size_t len);
+
+/* scrie (atomic) intrarea de tipul kind; intoarce 0 sau -1 */
+int cache_blob_store(const struct stat *st, uint32_t kind,
+		     const void *payload, size_t len);
+
+/*
+ * intoarce planul de incarcare din cache (tabela de segmente si numarul
+ * de pagini din fiecare segment) sau NULL
+ */
+so_exec_t *plan_cache_load(const struct stat *st, unsigned int **pages_no);
+
+/* salveaza planul de incarcare al executabilului */
+void plan_cache_store(const struct stat *st, so_exec_t *exec,
+		      unsigned int *pages_no);
+
+#endif /* SO_PLAN_CACHE_H_ */
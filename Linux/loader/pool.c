@@ -0,0 +1,100 @@
+/*
+ * Pre-zeroed page pool
+ *
+ * 2018, Operating Systems
+ */
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+
+#include "pool.h"
+#include "threads.h"
+#include "stats.h"
+#include "utils.h"
+
+/*
+ * inel cu un singur producator (thread-ul de reumplere); paginile sunt
+ * intre tail (urmatoarea extrasa) si head (urmatoarea adaugata)
+ */
+static void **slots;
+static unsigned int size;
+static unsigned int head, tail;
+
+/* trezeste thread-ul de reumplere (un byte scris in pipe) */
+static int wake_fds[2];
+
+static void *pool_refill(void *arg)
+{
+	int page_size = getpagesize();
+	unsigned int h;
+	char buf[64];
+	void *page;
+
+	for (;;) {
+		h = __atomic_load_n(&head, __ATOMIC_RELAXED);
+		while (h - __atomic_load_n(&tail, __ATOMIC_ACQUIRE) < size) {
+			/* MAP_POPULATE aloca si zeroieste pagina acum */
+			page = mmap(NULL, page_size, PROT_READ | PROT_WRITE,
+				    MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE,
+				    -1, 0);
+			if (page == MAP_FAILED)
+				break;
+
+			slots[h % size] = page;
+			__atomic_store_n(&head, ++h, __ATOMIC_RELEASE);
+		}
+
+		if (read(wake_fds[0], buf, sizeof(buf)) < 0)
+			return NULL;
+	}
+
+	return NULL;
+}
+
+void pool_init(unsigned int pages)
+{
+	int ret;
+
+	size = pages;
+	slots = calloc(size, sizeof(*slots));
+	DIE(!slots, "calloc failed.");
+
+	ret = pipe(wake_fds);
+	DIE(ret < 0, "pipe failed.");
+	fcntl(wake_fds[1], F_SETFL, O_NONBLOCK);
+
+	loader_thread_start(pool_refill, NULL);
+}
+
+void *pool_get(void)
+{
+	unsigned int h, t;
+	void *page;
+
+	if (!slots)
+		return NULL;
+
+	do {
+		t = __atomic_load_n(&tail, __ATOMIC_RELAXED);
+		h = __atomic_load_n(&head, __ATOMIC_ACQUIRE);
+		if (t == h) {
+			STATS_ADD(pool_misses, 1);
+			page = NULL;
+			break;
+		}
+		page = slots[t % size];
+	} while (!__atomic_compare_exchange_n(&tail, &t, t + 1, 0,
+					      __ATOMIC_ACQ_REL,
+					      __ATOMIC_RELAXED));
+
+	if (page)
+		STATS_ADD(pool_hits, 1);
+
+	/* reumplerea incepe cand pool-ul ajunge la jumatate */
+	if (h - t <= size / 2 + 1)
+		write(wake_fds[1], "", 1);
+
+	return page;
+}
@@ -0,0 +1,23 @@
+/*
+ * Pre-zeroed page pool
+ *
+ * 2018, Operating Systems
+ */
+
+#ifndef SO_POOL_H_
+#define SO_POOL_H_
+
+/*
+ * porneste thread-ul care mentine pool-ul plin cu pages pagini anonime,
+ * deja alocate si zeroizate de kernel (fiecare pagina este o mapare
+ * separata, writable)
+ */
+void pool_init(unsigned int pages);
+
+/*
+ * extrage o pagina din pool sau intoarce NULL daca pool-ul este gol
+ * (async-signal-safe); apelantul o muta la adresa finala cu mremap
+ */
+void *pool_get(void);
+
+#endif /* SO_POOL_H_ */
@@ -0,0 +1,59 @@
+/*
+ * Kernel side page population
+ *
+ * 2018, Operating Systems
+ */
+
+#include <sys/mman.h>
+
+#include "populate.h"
+
+#ifndef MADV_POPULATE_READ
+#define MADV_POPULATE_READ	22
+#endif
+#ifndef MADV_POPULATE_WRITE
+#define MADV_POPULATE_WRITE	23
+#endif
+
+/* suportul pentru MADV_POPULATE_*, stabilit o data de populate_init */
+static int madv_populate;
+
+void populate_init(void)
+{
+	/*
+	 * kernel-ul valideaza sfatul inaintea lungimii: pentru len = 0,
+	 * un sfat cunoscut nu face nimic, unul necunoscut da EINVAL
+	 */
+	madv_populate = madvise(NULL, 0, MADV_POPULATE_READ) == 0;
+}
+
+int populate_kernel(void *addr, size_t len, int write)
+{
+	if (!madv_populate)
+		return -1;
+
+	return madvise(addr, len, write ? MADV_POPULATE_WRITE :
+					  MADV_POPULATE_READ);
+}
+
+int populate_file(void *addr, size_t len, int prot, int fd, off_t offset)
+{
+	int flags = MAP_PRIVATE | MAP_FIXED;
+	void *ret;
+
+	if (!madv_populate)
+		flags |= MAP_POPULATE;
+
+	ret = mmap(addr, len, prot, flags, fd, offset);
+	if (ret == MAP_FAILED)
+		return -1;
+
+	if ((flags & MAP_POPULATE) ||
+	    populate_kernel(addr, len, prot & PROT_WRITE) == 0)
+		return 0;
+
+	/* MADV_POPULATE_* nu este suportat: refacem maparea, populata */
+	ret = mmap(addr, len, prot, flags | MAP_POPULATE, fd, offset);
+
+	return ret == MAP_FAILED ? -1 : 0;
+}
@@ -0,0 +1,31 @@
+/*
+ * Kernel side page population
+ *
+ * 2018, Operating Systems
+ */
+
+#ifndef SO_POPULATE_H_
+#define SO_POPULATE_H_
+
+#include <stddef.h>
+#include <sys/types.h>
+
+/* verifica, o singura data, daca kernel-ul suporta MADV_POPULATE_* */
+void populate_init(void);
+
+/*
+ * cere kernel-ului sa populeze zona [addr, addr + len), deja mapata, cu un
+ * singur apel (MADV_POPULATE_WRITE daca write este nenul, altfel
+ * MADV_POPULATE_READ); intoarce -1 daca nu se poate (de exemplu pe
+ * kernel-urile mai vechi de 5.14, detectate de populate_init)
+ */
+int populate_kernel(void *addr, size_t len, int write);
+
+/*
+ * mapeaza [addr, addr + len) direct din fisier (MAP_PRIVATE | MAP_FIXED,
+ * permisiunile prot) si populeaza toata zona in kernel; fara
+ * MADV_POPULATE_* se foloseste MAP_POPULATE. Intoarce 0 sau -1.
+ */
+int populate_file(void *addr, size_t len, int prot, int fd, off_t offset);
+
+#endif /* SO_POPULATE_H_ */
@@ -0,0 +1,25 @@
+/*
+ * Local range server protocol
+ *
+ * 2018, Operating Systems
+ */
+
+#ifndef SO_RANGE_PROTO_H_
+#define SO_RANGE_PROTO_H_
+
+#include <stdint.h>
+
+/*
+ * cererea trimisa serverului pe un socket UNIX de tip stream:
+ *	len == 0 -> serverul raspunde cu dimensiunea fisierului (uint64_t)
+ *	len > 0  -> serverul raspunde cu min(len, dimensiune - offset) bytes
+ * Cererile de pe aceeasi conexiune sunt servite in ordine; conexiunile
+ * diferite sunt servite independent.
+ */
+struct range_req {
+	uint64_t offset;
+	uint32_t len;
+	uint32_t reserved;
+};
+
+#endif /* SO_RANGE_PROTO_H_ */
@@ -0,0 +1,545 @@
+/*
+ * Static reachability analysis of startup code pages
+ *
+ * 2018, Operating Systems
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "reach.h"
+#include "elf_syms.h"
+#include "utils.h"
+
+/* limita de instructiuni decodificate (protectie pentru binare mari) */
+#define MAX_INSNS	(1 << 20)
+
+/* tipul instructiunii decodificate */
+enum insn_kind {
+	/* executia continua cu instructiunea urmatoare */
+	INSN_NEXT,
+	/* call direct: tinta + instructiunea urmatoare */
+	INSN_CALL,
+	/* salt conditionat: tinta + instructiunea urmatoare */
+	INSN_JCC,
+	/* salt neconditionat direct: doar tinta */
+	INSN_JMP,
+	/* ret, salt indirect, hlt etc.: executia nu continua liniar */
+	INSN_STOP,
+	/* opcode necunoscut */
+	INSN_BAD,
+};
+
+/* un segment executabil, citit din fisier */
+struct text {
+	uintptr_t start;
+	uintptr_t end;
+	unsigned char *bytes;
+	/* bitmap cu inceputurile de instructiuni deja vizitate */
+	uint8_t *visited;
+};
+
+struct analysis {
+	struct text *text;
+	int text_no;
+	/* stiva de adrese de analizat */
+	uintptr_t *work;
+	int work_no, work_cap;
+	/* tintele call-urilor directe (inceputuri de functii) */
+	uintptr_t *calls;
+	int calls_no, calls_cap;
+	/* paginile atinse, in ordinea descoperirii */
+	uintptr_t *pages;
+	int pages_no, pages_cap;
+	int page_size;
+};
+
+static void push(uintptr_t **vec, int *no, int *cap, uintptr_t value)
+{
+	if (*no == *cap) {
+		*cap = *cap ? 2 * *cap : 64;
+		*vec = realloc(*vec, *cap * sizeof(uintptr_t));
+		DIE(!*vec, "realloc failed.");
+	}
+	(*vec)[(*no)++] = value;
+}
+
+static struct text *find_text(struct analysis *an, uintptr_t addr)
+{
+	int i;
+
+	for (i = 0; i < an->text_no; i++)
+		if (addr >= an->text[i].start && addr < an->text[i].end)
+			return &an->text[i];
+
+	return NULL;
+}
+
+/* lungimea octetilor ModRM/SIB/deplasament (adresare pe 32 de biti) */
+static int modrm_len(const unsigned char *p, const unsigned char *end)
+{
+	int mod, rm, len = 1;
+
+	if (p >= end)
+		return -1;
+
+	mod = p[0] >> 6;
+	rm = p[0] & 7;
+	if (mod == 3)
+		return 1;
+
+	if (rm == 4) {
+		if (p + 1 >= end)
+			return -1;
+		len++;
+		if (mod == 0 && (p[1] & 7) == 5)
+			len += 4;
+	} else if (mod == 0 && rm == 5) {
+		len += 4;
+	}
+
+	if (mod == 1)
+		len += 1;
+	else if (mod == 2)
+		len += 4;
+
+	return len;
+}
+
+/* decodifica opcode-urile 0F xx; intoarce lungimea de dupa opcode */
+static int decode_0f(const unsigned char *p, const unsigned char *end,
+		     int osize, enum insn_kind *kind, int32_t *rel)
+{
+	unsigned char op = p[0];
+	int len;
+
+	p++;
+	if (op >= 0x80 && op <= 0x8f) {
+		*kind = INSN_JCC;
+		if (p + osize > end)
+			return -1;
+		*rel = osize == 2 ? (int16_t)(p[0] | p[1] << 8) :
+			(int32_t)(p[0] | p[1] << 8 | p[2] << 16 |
+				  (uint32_t)p[3] << 24);
+		return 1 + osize;
+	}
+
+	if (op == 0x0b || op == 0xff) {
+		*kind = INSN_STOP;
+		return 1;
+	}
+
+	/* fara operanzi */
+	if (op == 0x05 || op == 0x06 || op == 0x07 || op == 0x08 ||
+	    op == 0x09 || (op >= 0x30 && op <= 0x37) || op == 0x77 ||
+	    op == 0xa0 || op == 0xa1 || op == 0xa2 || op == 0xa8 ||
+	    op == 0xa9 || op == 0xaa || (op >= 0xc8 && op <= 0xcf))
+		return 1;
+
+	/* instructiuni pe 3 octeti */
+	if (op == 0x38 || op == 0x3a) {
+		if (p >= end)
+			return -1;
+		len = modrm_len(p + 1, end);
+		return len < 0 ? -1 : 2 + len + (op == 0x3a);
+	}
+
+	len = modrm_len(p, end);
+	if (len < 0)
+		return -1;
+
+	/* ModRM + imm8 */
+	if ((op >= 0x70 && op <= 0x73) || op == 0xa4 || op == 0xac ||
+	    op == 0xba || op == 0xc2 || (op >= 0xc4 && op <= 0xc6))
+		return 1 + len + 1;
+
+	/* ModRM */
+	if (op <= 0x03 || op == 0x0d || (op >= 0x10 && op <= 0x2f) ||
+	    (op >= 0x40 && op <= 0x7f) || (op >= 0x90 && op <= 0x9f) ||
+	    op == 0xa3 || op == 0xa5 || (op >= 0xab && op <= 0xc1) ||
+	    op == 0xc3 || op == 0xc7 || op >= 0xd0)
+		return 1 + len;
+
+	*kind = INSN_BAD;
+	return 1;
+}
+
+/*
+ * decodifica o instructiune VEX (AVX); p indica octetul de dupa c4/c5.
+ * Intoarce lungimea de dupa c4/c5: restul prefixului, opcode-ul, ModRM si
+ * imediatul (in harta 0f3a si pentru cateva opcode-uri din harta 0f)
+ */
+static int decode_vex(const unsigned char *p, const unsigned char *end,
+		      unsigned char op)
+{
+	const unsigned char *q = p + (op == 0xc4 ? 2 : 1);
+	int map = op == 0xc4 ? p[0] & 0x1f : 1;
+	int imm = 0, len;
+	unsigned char opcode;
+
+	if (q >= end || map < 1 || map > 3)
+		return -1;
+	opcode = *q++;
+
+	/* vzeroupper/vzeroall nu au ModRM */
+	if (map == 1 && opcode == 0x77)
+		return q - p;
+
+	if (map == 3 || (map == 1 && ((opcode >= 0x70 && opcode <= 0x73) ||
+				      opcode == 0xc2 || opcode == 0xc4 ||
+				      opcode == 0xc5 || opcode == 0xc6)))
+		imm = 1;
+
+	len = modrm_len(q, end);
+	return len < 0 ? -1 : (q - p) + len + imm;
+}
+
+/*
+ * decodifica instructiunea de la p; intoarce lungimea ei (sau -1),
+ * tipul si deplasamentul tintei pentru salturile/apelurile directe
+ */
+static int decode(const unsigned char *p, const unsigned char *end,
+		  enum insn_kind *kind, int32_t *rel)
+{
+	const unsigned char *start = p;
+	int osize = 4, len, reg;
+	unsigned char op;
+
+	*kind = INSN_NEXT;
+
+	/* prefixe */
+	for (; p < end; p++) {
+		if (*p == 0x66)
+			osize = 2;
+		else if (*p == 0x67) {
+			/* adresare pe 16 biti: nu o tratam */
+			*kind = INSN_BAD;
+			return 1;
+		} else if (*p != 0xf0 && *p != 0xf2 && *p != 0xf3 &&
+			   *p != 0x26 && *p != 0x2e && *p != 0x36 &&
+			   *p != 0x3e && *p != 0x64 && *p != 0x65)
+			break;
+	}
+	if (p >= end)
+		return -1;
+
+	op = *p++;
+
+	if (op == 0x0f) {
+		if (p >= end)
+			return -1;
+		len = decode_0f(p, end, osize, kind, rel);
+		return len < 0 ? -1 : (p - start) + len;
+	}
+
+	/* 00-3F: operatii aritmetice/logice */
+	if (op < 0x40 && (op & 7) < 6) {
+		if ((op & 7) < 4)
+			len = modrm_len(p, end);
+		else
+			len = (op & 7) == 4 ? 1 : osize;
+		return len < 0 ? -1 : (p - start) + len;
+	}
+	if (op < 0x40 || (op >= 0x40 && op <= 0x61) ||
+	    (op >= 0x6c && op <= 0x6f) || (op >= 0x90 && op <= 0x99) ||
+	    (op >= 0x9b && op <= 0x9f) || (op >= 0xa4 && op <= 0xa7) ||
+	    (op >= 0xaa && op <= 0xaf) || op == 0xc9 || op == 0xce ||
+	    op == 0xd6 || op == 0xd7 || (op >= 0xec && op <= 0xef) ||
+	    op == 0xf1 || op == 0xf5 || (op >= 0xf8 && op <= 0xfd))
+		return p - start;
+
+	switch (op) {
+	case 0x68:
+		return (p - start) + osize;
+	case 0x6a:
+	case 0xa8:
+	case 0xcd:
+	case 0xd4:
+	case 0xd5:
+		return (p - start) + 1;
+	case 0xa9:
+		return (p - start) + osize;
+	case 0xa0:
+	case 0xa1:
+	case 0xa2:
+	case 0xa3:
+		return (p - start) + 4;
+	case 0xc2:
+	case 0xca:
+		*kind = INSN_STOP;
+		return (p - start) + 2;
+	case 0xc3:
+	case 0xcb:
+	case 0xcc:
+	case 0xcf:
+	case 0xf4:
+		*kind = INSN_STOP;
+		return p - start;
+	case 0xc8:
+		return (p - start) + 3;
+	case 0x9a:
+	case 0xea:
+		*kind = INSN_STOP;
+		return (p - start) + osize + 2;
+	case 0xe8:
+	case 0xe9:
+		if (p + osize > end)
+			return -1;
+		*kind = op == 0xe8 ? INSN_CALL : INSN_JMP;
+		*rel = osize == 2 ? (int16_t)(p[0] | p[1] << 8) :
+			(int32_t)(p[0] | p[1] << 8 | p[2] << 16 |
+				  (uint32_t)p[3] << 24);
+		return (p - start) + osize;
+	case 0xeb:
+		if (p >= end)
+			return -1;
+		*kind = INSN_JMP;
+		*rel = (int8_t)p[0];
+		return (p - start) + 1;
+	}
+
+	if ((op >= 0x70 && op <= 0x7f) || (op >= 0xe0 && op <= 0xe3)) {
+		if (p >= end)
+			return -1;
+		*kind = INSN_JCC;
+		*rel = (int8_t)p[0];
+		return (p - start) + 1;
+	}
+
+	if ((op >= 0xb0 && op <= 0xb7) || (op >= 0xe4 && op <= 0xe7))
+		return (p - start) + 1;
+	if (op >= 0xb8 && op <= 0xbf)
+		return (p - start) + osize;
+
+	/*
+	 * les/lds nu accepta un registru ca operand, deci in modul pe 32 de
+	 * biti c4/c5 urmat de un octet cu mod == 3 este un prefix VEX
+	 */
+	if ((op == 0xc4 || op == 0xc5) && p < end && (p[0] & 0xc0) == 0xc0) {
+		len = decode_vex(p, end, op);
+		return len < 0 ? -1 : (p - start) + len;
+	}
+
+	len = modrm_len(p, end);
+	if (len < 0)
+		return -1;
+	reg = (p[0] >> 3) & 7;
+
+	switch (op) {
+	case 0x69:
+	case 0x81:
+	case 0xc7:
+		return (p - start) + len + osize;
+	case 0x6b:
+	case 0x80:
+	case 0x82:
+	case 0x83:
+	case 0xc0:
+	case 0xc1:
+	case 0xc6:
+		return (p - start) + len + 1;
+	case 0xf6:
+		return (p - start) + len + (reg < 2 ? 1 : 0);
+	case 0xf7:
+		return (p - start) + len + (reg < 2 ? osize : 0);
+	case 0xff:
+		/* jmp indirect (near/far) si call far */
+		if (reg == 3 || reg == 4 || reg == 5)
+			*kind = INSN_STOP;
+		return (p - start) + len;
+	}
+
+	if (op == 0x62 || op == 0x63 || (op >= 0x84 && op <= 0x8f) ||
+	    op == 0xc4 || op == 0xc5 || (op >= 0xd0 && op <= 0xd3) ||
+	    (op >= 0xd8 && op <= 0xdf) || op == 0xfe)
+		return (p - start) + len;
+
+	*kind = INSN_BAD;
+	return 1;
+}
+
+static void add_page(struct analysis *an, uintptr_t addr)
+{
+	push(&an->pages, &an->pages_no, &an->pages_cap,
+	     ALIGN_DOWN(addr, (uintptr_t)an->page_size));
+}
+
+/* decodifica liniar de la addr pana la o instructiune care opreste fluxul */
+static void sweep(struct analysis *an, uintptr_t addr, int *budget)
+{
+	struct text *text = find_text(an, addr);
+	enum insn_kind kind;
+	int32_t rel = 0;
+	uintptr_t off;
+	int len;
+
+	while (text && addr < text->end && (*budget)-- > 0) {
+		off = addr - text->start;
+		if (text->visited[off / 8] & (1 << (off % 8)))
+			return;
+		text->visited[off / 8] |= 1 << (off % 8);
+
+		len = decode(text->bytes + off, text->bytes +
+			     (text->end - text->start), &kind, &rel);
+		if (len < 0 || kind == INSN_BAD)
+			return;
+
+		add_page(an, addr);
+		if (ALIGN_DOWN(addr + len - 1, (uintptr_t)an->page_size) !=
+		    ALIGN_DOWN(addr, (uintptr_t)an->page_size))
+			add_page(an, addr + len - 1);
+
+		addr += len;
+		switch (kind) {
+		case INSN_CALL:
+			push(&an->calls, &an->calls_no, &an->calls_cap,
+			     addr + rel);
+			/* fall through */
+		case INSN_JCC:
+			push(&an->work, &an->work_no, &an->work_cap,
+			     addr + rel);
+			break;
+		case INSN_JMP:
+			push(&an->work, &an->work_no, &an->work_cap,
+			     addr + rel);
+			return;
+		case INSN_STOP:
+		case INSN_BAD:
+			return;
+		case INSN_NEXT:
+			break;
+		}
+	}
+}
+
+static int cmp_addr(const void *a, const void *b)
+{
+	uintptr_t x = *(const uintptr_t *)a, y = *(const uintptr_t *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+/* sorteaza paginile si elimina duplicatele */
+static int unique_pages(uintptr_t *pages, int count)
+{
+	int i, j = 0;
+
+	qsort(pages, count, sizeof(uintptr_t), cmp_addr);
+	for (i = 0; i < count; i++)
+		if (j == 0 || pages[j - 1] != pages[i])
+			pages[j++] = pages[i];
+
+	return j;
+}
+
+/* adauga toate paginile functiilor apelate/atinse (din .symtab) */
+static void add_functions(struct analysis *an, int fd)
+{
+	struct elf_syms syms;
+	struct elf_sym *sym;
+	uintptr_t addr;
+	int i;
+
+	if (elf_syms_read(fd, &syms) < 0)
+		return;
+
+	for (i = 0; i < an->calls_no; i++) {
+		sym = elf_syms_find(&syms, an->calls[i]);
+		if (!sym || !find_text(an, sym->addr))
+			continue;
+		for (addr = sym->addr; addr < sym->addr + sym->size;
+		     addr += an->page_size)
+			add_page(an, addr);
+		if (sym->size)
+			add_page(an, sym->addr + sym->size - 1);
+	}
+
+	elf_syms_free(&syms);
+}
+
+static int read_text(struct analysis *an, so_exec_t *exec, int fd)
+{
+	struct text *text;
+	so_seg_t *seg;
+	ssize_t ret;
+	size_t done;
+	int i;
+
+	an->text = calloc(exec->segments_no, sizeof(struct text));
+	DIE(!an->text, "calloc failed.");
+
+	for (i = 0; i < exec->segments_no; i++) {
+		seg = &exec->segments[i];
+		if (!(seg->perm & PERM_X) || !seg->file_size)
+			continue;
+
+		text = &an->text[an->text_no++];
+		text->start = seg->vaddr;
+		text->end = seg->vaddr + seg->file_size;
+		text->bytes = malloc(seg->file_size);
+		text->visited = calloc(seg->file_size / 8 + 1, 1);
+		DIE(!text->bytes || !text->visited, "malloc failed.");
+
+		for (done = 0; done < seg->file_size; done += ret) {
+			ret = pread(fd, text->bytes + done,
+				    seg->file_size - done, seg->offset + done);
+			if (ret <= 0)
+				return -1;
+		}
+	}
+
+	return 0;
+}
+
+static void free_analysis(struct analysis *an)
+{
+	int i;
+
+	for (i = 0; i < an->text_no; i++) {
+		free(an->text[i].bytes);
+		free(an->text[i].visited);
+	}
+	free(an->text);
+	free(an->work);
+	free(an->calls);
+}
+
+int reach_analyze(so_exec_t *exec, int fd, const struct stat *st,
+		  uintptr_t **pages)
+{
+	struct analysis an;
+	int budget = MAX_INSNS;
+	void *cached;
+	size_t len;
+
+	if (st) {
+		cached = cache_blob_map(st, CACHE_KIND_REACH, &len);
+		if (cached) {
+			*pages = malloc(len + 1);
+			DIE(!*pages, "malloc failed.");
+			memcpy(*pages, cached, len);
+			cache_blob_unmap(cached, len);
+			return len / sizeof(uintptr_t);
+		}
+	}
+
+	memset(&an, 0, sizeof(an));
+	an.page_size = getpagesize();
+
+	if (read_text(&an, exec, fd) == 0) {
+		push(&an.work, &an.work_no, &an.work_cap, exec->entry);
+		while (an.work_no > 0 && budget > 0)
+			sweep(&an, an.work[--an.work_no], &budget);
+		add_functions(&an, fd);
+	}
+	free_analysis(&an);
+
+	an.pages_no = unique_pages(an.pages, an.pages_no);
+	if (st)
+		cache_blob_store(st, CACHE_KIND_REACH, an.pages,
+				 an.pages_no * sizeof(uintptr_t));
+
+	*pages = an.pages;
+	return an.pages_no;
+}
@@ -0,0 +1,30 @@
+/*
+ * Static reachability analysis of startup code pages
+ *
+ * 2018, Operating Systems
+ */
+
+#ifndef SO_REACH_H_
+#define SO_REACH_H_
+
+#include <stdint.h>
+#include <sys/stat.h>
+
+#include "exec_parser.h"
+#include "plan_cache.h"
+
+#define CACHE_KIND_REACH	CACHE_KIND('r', 'e', 'a', 'c')
+
+/*
+ * calculeaza multimea de pagini de cod (adrese de inceput, sortate) pe
+ * care programul le va executa, probabil, la pornire: se decodifica
+ * liniar instructiunile x86 pornind de la entry point si se urmaresc
+ * tintele directe ale instructiunilor call/jmp/jcc; paginile functiilor
+ * atinse (daca exista .symtab) sunt adaugate in intregime.
+ * Rezultatul este citit/salvat in cache daca st este nenul.
+ * Intoarce numarul de pagini (*pages se elibereaza cu free).
+ */
+int reach_analyze(so_exec_t *exec, int fd, const struct stat *st,
+		  uintptr_t **pages);
+
+#endif /* SO_REACH_H_ */
@@ -0,0 +1,585 @@
+/*
+ * Executable data sources
+ *
+ * 2018, Operating Systems
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <fcntl.h>
+
+#include "source.h"
+#include "range_proto.h"
+#include "chunk_store.h"
+#include "config.h"
+#include "threads.h"
+#include "page_ops.h"
+#include "stats.h"
+#include "utils.h"
+
+/* dimensiunea blocurilor citite in fundal */
+#define FETCH_CHUNK	(64 * 1024)
+
+/* starea unui bloc al sursei de tip range */
+#define CHUNK_ABSENT	0
+#define CHUNK_FETCHING	1
+#define CHUNK_PRESENT	2
+
+/* sursa de tip stream (pipe): datele sosesc secvential */
+struct stream {
+	int fd;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	char *buf;
+	size_t size, cap;
+	int eof;
+};
+
+/* sursa de tip chunks: bucatile fisierului sunt citite dintr-un store */
+struct chunks {
+	const char *store;
+	struct chunk_recipe_hdr hdr;
+	struct chunk_id *ids;
+	/* sursa din care sunt aduse bucatile lipsa din store (sau NULL) */
+	struct so_source *origin;
+	/* buffer-ul unei bucati aduse din origine, alocat la deschidere */
+	char *chunk;
+	pthread_mutex_t lock;
+};
+
+/* sursa de tip range: datele sunt cerute pe intervale unui server local */
+struct range {
+	/* conexiunea folosita de page fault-uri (prioritara) */
+	int prio_fd;
+	/*
+	 * pot cere blocuri mai multe thread-uri deodata (handler-ul, eager,
+	 * indicii); o pereche cerere/raspuns ocupa conexiunea pana la capat
+	 */
+	pthread_mutex_t prio_lock;
+	/* conexiunea folosita de thread-ul de fundal */
+	int bg_fd;
+	uint64_t size;
+	char *buf;
+	uint8_t *state;
+	size_t chunks;
+	/* numarul de page fault-uri care asteapta date */
+	int waiting;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+};
+
+static ssize_t file_read(struct so_source *src, void *buf, size_t len,
+			 off_t offset)
+{
+	size_t done = 0;
+	ssize_t ret;
+
+	if (src->map) {
+		if ((size_t)offset >= src->map_size)
+			return 0;
+		if (len > src->map_size - offset)
+			len = src->map_size - offset;
+		page_copy(buf, src->map + offset, len);
+		return len;
+	}
+
+	while (done < len) {
+		ret = pread(src->fd, (char *)buf + done, len - done,
+			    offset + done);
+		STATS_ADD(read_syscalls, 1);
+		if (ret < 0)
+			return -1;
+		if (ret == 0)
+			break;
+		done += ret;
+	}
+
+	return done;
+}
+
+static ssize_t stream_read(struct so_source *src, void *buf, size_t len,
+			   off_t offset)
+{
+	struct stream *stream = src->priv;
+	size_t end = offset + len;
+
+	pthread_mutex_lock(&stream->lock);
+	while (stream->size < end && !stream->eof)
+		pthread_cond_wait(&stream->cond, &stream->lock);
+
+	if (end > stream->size)
+		end = stream->size;
+	len = (size_t)offset < end ? end - offset : 0;
+	page_copy(buf, stream->buf + offset, len);
+	pthread_mutex_unlock(&stream->lock);
+
+	return len;
+}
+
+/* citeste secvential datele din pipe */
+static void *stream_fetch(void *arg)
+{
+	struct stream *stream = arg;
+	char chunk[FETCH_CHUNK];
+	ssize_t ret;
+
+	do {
+		ret = read(stream->fd, chunk, sizeof(chunk));
+		if (ret < 0 && errno == EINTR)
+			continue;
+
+		pthread_mutex_lock(&stream->lock);
+		if (ret > 0) {
+			if (stream->size + ret > stream->cap) {
+				stream->cap = 2 * (stream->size + ret);
+				stream->buf = realloc(stream->buf, stream->cap);
+				DIE(!stream->buf, "realloc failed.");
+			}
+			memcpy(stream->buf + stream->size, chunk, ret);
+			stream->size += ret;
+		} else {
+			stream->eof = 1;
+		}
+		pthread_cond_broadcast(&stream->cond);
+		pthread_mutex_unlock(&stream->lock);
+	} while (ret != 0 && !(ret < 0 && errno != EINTR));
+
+	return NULL;
+}
+
+static struct so_source *stream_open(int fd)
+{
+	struct so_source *src = calloc(1, sizeof(*src));
+	struct stream *stream = calloc(1, sizeof(*stream));
+
+	DIE(!src || !stream, "calloc failed.");
+
+	stream->fd = fd;
+	pthread_mutex_init(&stream->lock, NULL);
+	pthread_cond_init(&stream->cond, NULL);
+
+	src->read = stream_read;
+	src->fd = -1;
+	src->size = -1;
+	src->priv = stream;
+
+	loader_thread_start(stream_fetch, stream);
+
+	return src;
+}
+
+static int send_all(int fd, const void *buf, size_t len)
+{
+	ssize_t ret;
+
+	while (len > 0) {
+		ret = send(fd, buf, len, MSG_NOSIGNAL);
+		if (ret < 0 && errno == EINTR)
+			continue;
+		if (ret <= 0)
+			return -1;
+		buf = (const char *)buf + ret;
+		len -= ret;
+	}
+
+	return 0;
+}
+
+static int recv_all(int fd, void *buf, size_t len)
+{
+	ssize_t ret;
+
+	while (len > 0) {
+		ret = recv(fd, buf, len, 0);
+		if (ret < 0 && errno == EINTR)
+			continue;
+		if (ret <= 0)
+			return -1;
+		buf = (char *)buf + ret;
+		len -= ret;
+	}
+
+	return 0;
+}
+
+static int range_connect(const char *path)
+{
+	struct sockaddr_un addr;
+	int fd;
+
+	if (strlen(path) >= sizeof(addr.sun_path))
+		return -1;
+
+	fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (fd < 0)
+		return -1;
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strcpy(addr.sun_path, path);
+	if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+		close(fd);
+		return -1;
+	}
+
+	return fd;
+}
+
+/* aduce blocul idx de la server, pe conexiunea fd */
+static void range_fetch_chunk(struct range *range, int fd, size_t idx)
+{
+	struct range_req req;
+	uint64_t offset = (uint64_t)idx * FETCH_CHUNK;
+
+	memset(&req, 0, sizeof(req));
+	req.offset = offset;
+	req.len = range->size - offset < FETCH_CHUNK ?
+		  range->size - offset : FETCH_CHUNK;
+
+	DIE(send_all(fd, &req, sizeof(req)) < 0 ||
+	    recv_all(fd, range->buf + offset, req.len) < 0,
+	    "range fetch failed");
+}
+
+static ssize_t range_read(struct so_source *src, void *buf, size_t len,
+			  off_t offset)
+{
+	struct range *range = src->priv;
+	size_t idx, first, last;
+
+	if ((uint64_t)offset >= range->size)
+		return 0;
+	if (len > range->size - offset)
+		len = range->size - offset;
+	if (len == 0)
+		return 0;
+
+	first = offset / FETCH_CHUNK;
+	last = (offset + len - 1) / FETCH_CHUNK;
+
+	pthread_mutex_lock(&range->lock);
+	range->waiting++;
+	for (idx = first; idx <= last; idx++) {
+		while (range->state[idx] == CHUNK_FETCHING)
+			pthread_cond_wait(&range->cond, &range->lock);
+		if (range->state[idx] == CHUNK_PRESENT)
+			continue;
+
+		/* cerem blocul direct, inaintea celor citite in fundal */
+		range->state[idx] = CHUNK_FETCHING;
+		pthread_mutex_unlock(&range->lock);
+		pthread_mutex_lock(&range->prio_lock);
+		range_fetch_chunk(range, range->prio_fd, idx);
+		pthread_mutex_unlock(&range->prio_lock);
+		pthread_mutex_lock(&range->lock);
+		range->state[idx] = CHUNK_PRESENT;
+		pthread_cond_broadcast(&range->cond);
+	}
+	range->waiting--;
+	pthread_cond_broadcast(&range->cond);
+	pthread_mutex_unlock(&range->lock);
+
+	page_copy(buf, range->buf + offset, len);
+	return len;
+}
+
+/* aduce secvential blocurile lipsa, cedand locul page fault-urilor */
+static void *range_fetch(void *arg)
+{
+	struct range *range = arg;
+	size_t idx;
+
+	for (idx = 0; idx < range->chunks; idx++) {
+		pthread_mutex_lock(&range->lock);
+		while (range->waiting > 0)
+			pthread_cond_wait(&range->cond, &range->lock);
+		if (range->state[idx] != CHUNK_ABSENT) {
+			pthread_mutex_unlock(&range->lock);
+			continue;
+		}
+		range->state[idx] = CHUNK_FETCHING;
+		pthread_mutex_unlock(&range->lock);
+
+		range_fetch_chunk(range, range->bg_fd, idx);
+
+		pthread_mutex_lock(&range->lock);
+		range->state[idx] = CHUNK_PRESENT;
+		pthread_cond_broadcast(&range->cond);
+		pthread_mutex_unlock(&range->lock);
+	}
+
+	close(range->bg_fd);
+	return NULL;
+}
+
+static struct so_source *range_open(const char *path)
+{
+	struct so_source *src;
+	struct range *range;
+	struct range_req req;
+
+	range = calloc(1, sizeof(*range));
+	DIE(!range, "calloc failed.");
+
+	range->prio_fd = range_connect(path);
+	range->bg_fd = range_connect(path);
+	if (range->prio_fd < 0 || range->bg_fd < 0) {
+		perror("connect");
+		goto out_free;
+	}
+
+	/* aflam dimensiunea fisierului */
+	memset(&req, 0, sizeof(req));
+	if (send_all(range->prio_fd, &req, sizeof(req)) < 0 ||
+	    recv_all(range->prio_fd, &range->size, sizeof(range->size)) < 0) {
+		fprintf(stderr, "range server handshake failed\n");
+		goto out_free;
+	}
+
+	range->chunks = (range->size + FETCH_CHUNK - 1) / FETCH_CHUNK;
+	range->buf = malloc(range->size + 1);
+	range->state = calloc(range->chunks + 1, 1);
+	DIE(!range->buf || !range->state, "malloc failed.");
+	pthread_mutex_init(&range->lock, NULL);
+	pthread_mutex_init(&range->prio_lock, NULL);
+	pthread_cond_init(&range->cond, NULL);
+
+	src = calloc(1, sizeof(*src));
+	DIE(!src, "calloc failed.");
+	src->read = range_read;
+	src->fd = -1;
+	src->size = range->size;
+	src->priv = range;
+
+	loader_thread_start(range_fetch, range);
+
+	return src;
+
+out_free:
+	if (range->prio_fd >= 0)
+		close(range->prio_fd);
+	if (range->bg_fd >= 0)
+		close(range->bg_fd);
+	free(range);
+	return NULL;
+}
+
+/*
+ * aduce bucata idx din sursa de origine, ii verifica hash-ul si o adauga
+ * in store; intoarce 0 sau -1
+ */
+static int chunks_fetch(struct chunks *chunks, size_t idx, char *buf,
+			size_t len)
+{
+	struct chunk_id id;
+
+	if (!chunks->origin ||
+	    source_read(chunks->origin, buf, len,
+			(off_t)idx * chunks->hdr.chunk_size) != (ssize_t)len)
+		return -1;
+
+	chunk_hash(buf, len, &id);
+	if (memcmp(&id, &chunks->ids[idx], sizeof(id))) {
+		fprintf(stderr, "so_loader: chunk %zu does not match recipe\n",
+			idx);
+		return -1;
+	}
+
+	STATS_ADD(chunks_fetched, 1);
+	if (chunk_store_put(chunks->store, &id, buf, len) < 0)
+		perror("chunk_store_put");
+
+	return 0;
+}
+
+static ssize_t chunks_read(struct so_source *src, void *buf, size_t len,
+			   off_t offset)
+{
+	struct chunks *chunks = src->priv;
+	size_t chunk_size = chunks->hdr.chunk_size;
+	size_t done = 0, idx, in_chunk, chunk_len, n;
+	char path[4096];
+	ssize_t ret;
+	int fd;
+
+	if ((uint64_t)offset >= chunks->hdr.file_size)
+		return 0;
+	if (len > chunks->hdr.file_size - offset)
+		len = chunks->hdr.file_size - offset;
+
+	while (done < len) {
+		idx = (offset + done) / chunk_size;
+		in_chunk = (offset + done) % chunk_size;
+		chunk_len = chunks->hdr.file_size - idx * chunk_size;
+		if (chunk_len > chunk_size)
+			chunk_len = chunk_size;
+		n = chunk_len - in_chunk;
+		if (n > len - done)
+			n = len - done;
+
+		/* bucatile identice sunt acelasi fisier (o copie in cache) */
+		chunk_path(chunks->store, &chunks->ids[idx], path,
+			   sizeof(path));
+		fd = open(path, O_RDONLY);
+		if (fd >= 0) {
+			ret = pread(fd, (char *)buf + done, n, in_chunk);
+			STATS_ADD(read_syscalls, 1);
+			close(fd);
+			if (ret != (ssize_t)n)
+				return -1;
+		} else {
+			pthread_mutex_lock(&chunks->lock);
+			ret = chunks_fetch(chunks, idx, chunks->chunk,
+					   chunk_len);
+			if (!ret)
+				memcpy((char *)buf + done,
+				       chunks->chunk + in_chunk, n);
+			pthread_mutex_unlock(&chunks->lock);
+			if (ret < 0)
+				return -1;
+		}
+
+		done += n;
+	}
+
+	return done;
+}
+
+static struct so_source *chunks_open(const char *recipe)
+{
+	struct so_source *src;
+	struct chunks *chunks;
+	size_t len;
+	int fd;
+
+	if (!so_cfg.chunk_store) {
+		fprintf(stderr,
+			"so_loader: SO_LOADER_CHUNK_STORE is not set\n");
+		return NULL;
+	}
+
+	fd = open(recipe, O_RDONLY);
+	if (fd < 0) {
+		perror("open");
+		return NULL;
+	}
+
+	chunks = calloc(1, sizeof(*chunks));
+	DIE(!chunks, "calloc failed.");
+	chunks->store = so_cfg.chunk_store;
+
+	if (pread(fd, &chunks->hdr, sizeof(chunks->hdr), 0) !=
+	    sizeof(chunks->hdr) || chunks->hdr.magic != CHUNK_RECIPE_MAGIC ||
+	    chunks->hdr.version != CHUNK_RECIPE_VERSION ||
+	    chunks->hdr.hdr_size != sizeof(chunks->hdr) ||
+	    chunks->hdr.chunk_size == 0 ||
+	    chunks->hdr.chunks_no != (chunks->hdr.file_size +
+				      chunks->hdr.chunk_size - 1) /
+				     chunks->hdr.chunk_size ||
+	    (uint64_t)chunks->hdr.chunks_no * sizeof(*chunks->ids) > SIZE_MAX)
+		goto out_invalid;
+
+	len = chunks->hdr.chunks_no * sizeof(*chunks->ids);
+	chunks->ids = malloc(len);
+	DIE(!chunks->ids, "malloc failed.");
+	if (pread(fd, chunks->ids, len, sizeof(chunks->hdr)) != (ssize_t)len)
+		goto out_invalid;
+	close(fd);
+
+	chunks->chunk = malloc(chunks->hdr.chunk_size);
+	DIE(!chunks->chunk, "malloc failed.");
+	pthread_mutex_init(&chunks->lock, NULL);
+
+	if (so_cfg.chunk_origin) {
+		chunks->origin = source_open(so_cfg.chunk_origin);
+		if (!chunks->origin)
+			fprintf(stderr, "so_loader: chunk origin %s is "
+				"unavailable\n", so_cfg.chunk_origin);
+	}
+
+	src = calloc(1, sizeof(*src));
+	DIE(!src, "calloc failed.");
+	src->read = chunks_read;
+	src->fd = -1;
+	src->size = chunks->hdr.file_size;
+	src->priv = chunks;
+
+	return src;
+
+out_invalid:
+	fprintf(stderr, "so_loader: invalid recipe %s\n", recipe);
+	close(fd);
+	free(chunks->ids);
+	free(chunks);
+	return NULL;
+}
+
+struct so_source *source_open(const char *path)
+{
+	struct so_source *src;
+	struct stat st;
+	int fd;
+
+	if (!strcmp(path, "-"))
+		return stream_open(STDIN_FILENO);
+	if (!strncmp(path, "fd:", 3))
+		return stream_open(atoi(path + 3));
+	if (!strncmp(path, "unix:", 5))
+		return range_open(path + 5);
+	if (!strncmp(path, "chunks:", 7))
+		return chunks_open(path + 7);
+
+	fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		perror("open");
+		return NULL;
+	}
+
+	src = calloc(1, sizeof(*src));
+	DIE(!src, "calloc failed.");
+	src->read = file_read;
+	src->fd = fd;
+	src->size = fstat(fd, &st) < 0 ? -1 : st.st_size;
+
+	return src;
+}
+
+int source_map(struct so_source *src, so_exec_t *exec)
+{
+	struct stat st;
+	uintptr_t start, end;
+	void *map;
+	int i;
+
+	if (src->fd < 0 || fstat(src->fd, &st) < 0 || st.st_size == 0)
+		return -1;
+
+	map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, src->fd, 0);
+	if (map == MAP_FAILED)
+		return -1;
+
+	/* segmentele vor fi mapate MAP_FIXED peste aceasta zona */
+	start = (uintptr_t)map;
+	end = start + st.st_size;
+	for (i = 0; i < exec->segments_no; i++) {
+		if (start < exec->segments[i].vaddr + exec->segments[i].mem_size
+		    && exec->segments[i].vaddr < end) {
+			munmap(map, st.st_size);
+			return -1;
+		}
+	}
+
+	src->map = map;
+	src->map_size = st.st_size;
+
+	return 0;
+}
@@ -0,0 +1,59 @@
+/*
+ * Executable data sources
+ *
+ * 2018, Operating Systems
+ */
+
+#ifndef SO_SOURCE_H_
+#define SO_SOURCE_H_
+
+#include <stddef.h>
+#include <sys/types.h>
+
+#include "exec_parser.h"
+
+/*
+ * sursa din care sunt citite datele executabilului:
+ *	<cale>		fisier obisnuit (citit cu pread sau mapat, in modul mmap)
+ *	-		stdin (pipe), citit secvential in fundal
+ *	fd:<n>		descriptorul n (pipe), citit secvential in fundal
+ *	unix:<socket>	server local de intervale (vezi tools/so_range_server.c)
+ *	chunks:<reteta>	bucati dintr-un store adresat dupa continut (vezi
+ *			tools/so_chunk.c si chunk_store.h)
+ */
+struct so_source {
+	/*
+	 * citeste len bytes de la offset; pentru sursele de tip stream
+	 * asteapta pana cand datele ajung. Intoarce numarul de bytes cititi
+	 * (mai putin doar la sfarsitul fisierului) sau -1.
+	 */
+	ssize_t (*read)(struct so_source *src, void *buf, size_t len,
+			off_t offset);
+	/* descriptorul fisierului obisnuit sau -1 pentru celelalte surse */
+	int fd;
+	/* dimensiunea fisierului sau -1 daca nu este cunoscuta (stream) */
+	off_t size;
+	/* maparea fisierului (modul mmap) sau NULL */
+	const char *map;
+	size_t map_size;
+	/* datele specifice sursei */
+	void *priv;
+};
+
+/* deschide sursa descrisa de path; intoarce NULL la eroare */
+struct so_source *source_open(const char *path);
+
+/*
+ * mapeaza read-only fisierul (daca sursa este un fisier obisnuit) pentru
+ * modul mmap; intoarce -1 daca maparea nu se poate folosi (de exemplu
+ * daca s-ar suprapune peste vreun segment al executabilului)
+ */
+int source_map(struct so_source *src, so_exec_t *exec);
+
+static inline ssize_t source_read(struct so_source *src, void *buf,
+				  size_t len, off_t offset)
+{
+	return src->read(src, buf, len, offset);
+}
+
+#endif /* SO_SOURCE_H_ */
@@ -0,0 +1,153 @@
+/*
+ * Loader statistics
+ *
+ * 2018, Operating Systems
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <fcntl.h>
+
+#include "stats.h"
+#include "config.h"
+#include "page_ops.h"
+#include "perf_counters.h"
+#include "utils.h"
+
+struct so_stats *so_stats;
+
+void stats_init(void)
+{
+	void *ret;
+
+	ret = mmap(NULL, sizeof(*so_stats), PROT_READ | PROT_WRITE,
+		   MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	DIE(ret == MAP_FAILED, "mmap failed.");
+
+	so_stats = ret;
+}
+
+void stats_sample_vmas(void)
+{
+	char buf[4096];
+	uint64_t vmas = 0;
+	ssize_t ret, i;
+	int fd;
+
+	fd = open("/proc/self/maps", O_RDONLY);
+	if (fd < 0)
+		return;
+
+	while ((ret = read(fd, buf, sizeof(buf))) > 0)
+		for (i = 0; i < ret; i++)
+			vmas += buf[i] == '\n';
+	close(fd);
+
+	if (vmas > so_stats->vmas_max)
+		so_stats->vmas_max = vmas;
+}
+
+static void stats_report(void)
+{
+	uint64_t faults = so_stats->faults;
+	int i;
+
+	fprintf(stderr, "so_loader: io=%s reserve=%d simd=%s faults=%llu "
+		"ns/fault=%llu vmas_max=%llu\n",
+		so_cfg.io_mode == IO_MMAP ? "mmap" : "read", so_cfg.reserve,
+		so_page_ops.name,
+		(unsigned long long)faults,
+		(unsigned long long)(faults ? so_stats->fault_ns / faults : 0),
+		(unsigned long long)so_stats->vmas_max);
+	fprintf(stderr, "so_loader: bytes_read=%llu read_syscalls=%llu "
+		"prefaulted=%llu zero_skipped=%llu\n",
+		(unsigned long long)so_stats->bytes_read,
+		(unsigned long long)so_stats->read_syscalls,
+		(unsigned long long)so_stats->prefaulted,
+		(unsigned long long)so_stats->zero_skipped);
+	fprintf(stderr, "so_loader: fault_around=%d faulted_around=%llu "
+		"entry_us=%llu\n", so_cfg.fault_around,
+		(unsigned long long)so_stats->faulted_around,
+		(unsigned long long)(so_stats->entry_ns / 1000));
+
+	if (so_stats->populate_calls)
+		fprintf(stderr, "so_loader: populate_calls=%llu "
+			"populate_pages=%llu pages/call=%llu max=%llu "
+			"direct=%llu\n",
+			(unsigned long long)so_stats->populate_calls,
+			(unsigned long long)so_stats->populate_pages,
+			(unsigned long long)(so_stats->populate_pages /
+					     so_stats->populate_calls),
+			(unsigned long long)so_stats->populate_max,
+			(unsigned long long)so_stats->populate_direct);
+
+	if (so_stats->eager_pages)
+		fprintf(stderr, "so_loader: eager_pages=%llu eager_ms=%llu "
+			"threads=%d\n",
+			(unsigned long long)so_stats->eager_pages,
+			(unsigned long long)(so_stats->eager_ns / 1000000),
+			so_cfg.threads);
+
+	if (so_cfg.pool)
+		fprintf(stderr, "so_loader: pool=%d pool_hits=%llu "
+			"pool_misses=%llu\n", so_cfg.pool,
+			(unsigned long long)so_stats->pool_hits,
+			(unsigned long long)so_stats->pool_misses);
+
+	if (so_cfg.hints)
+		fprintf(stderr, "so_loader: hints=%llu hint_populated=%llu "
+			"hint_dropped=%llu\n",
+			(unsigned long long)so_stats->hints,
+			(unsigned long long)so_stats->hint_populated,
+			(unsigned long long)so_stats->hint_dropped);
+
+	if (so_cfg.chunk_store)
+		fprintf(stderr, "so_loader: chunks_fetched=%llu\n",
+			(unsigned long long)so_stats->chunks_fetched);
+
+	if (so_stats->verified)
+		fprintf(stderr, "so_loader: verified=%llu ns/verify=%llu\n",
+			(unsigned long long)so_stats->verified,
+			(unsigned long long)(so_stats->verify_ns /
+					     so_stats->verified));
+
+	for (i = 0; i < NUMA_MAX_NODES; i++)
+		if (so_stats->numa_pages[i])
+			fprintf(stderr, "so_loader: numa node%d pages=%llu\n", i,
+				(unsigned long long)so_stats->numa_pages[i]);
+}
+
+void stats_watch(void)
+{
+	pid_t pid;
+	int status;
+
+	if (so_cfg.perf)
+		perf_prepare();
+
+	pid = fork();
+	DIE(pid < 0, "fork failed.");
+	if (pid == 0)
+		return;
+
+	/* contoarele sunt deschise cand copilul ajunge la entry point */
+	if (so_cfg.perf)
+		perf_attach(pid);
+
+	DIE(waitpid(pid, &status, 0) < 0, "waitpid failed.");
+
+	stats_report();
+	if (so_cfg.perf)
+		perf_report();
+
+	if (WIFSIGNALED(status)) {
+		signal(WTERMSIG(status), SIG_DFL);
+		raise(WTERMSIG(status));
+	}
+	exit(WEXITSTATUS(status));
+}
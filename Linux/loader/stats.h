@@ -0,0 +1,102 @@
+/*
+ * Loader statistics
+ *
+ * 2018, Operating Systems
+ */
+
+#ifndef SO_STATS_H_
+#define SO_STATS_H_
+
+#include <stdint.h>
+#include <time.h>
+
+#include "numa.h"
+
+/*
+ * contoarele loader-ului; se afla intr-o zona de memorie partajata, astfel
+ * incat procesul care supravegheaza executia sa le poata raporta dupa ce
+ * executabilul incarcat s-a terminat
+ */
+struct so_stats {
+	/* numarul de page fault-uri tratate */
+	uint64_t faults;
+	/* timpul total petrecut in tratarea lor */
+	uint64_t fault_ns;
+	/* numarul de bytes cititi din executabil */
+	uint64_t bytes_read;
+	/* numarul de apeluri de sistem pread facute pentru citire */
+	uint64_t read_syscalls;
+	/* numarul de pagini mapate in avans (fara page fault) */
+	uint64_t prefaulted;
+	/* numarul de pagini mapate impreuna cu pagina accesata */
+	uint64_t faulted_around;
+	/* paginile luate din pool si page fault-urile cu pool-ul gol */
+	uint64_t pool_hits;
+	uint64_t pool_misses;
+	/* cererile din pagina de indicii si paginile populate/eliberate */
+	uint64_t hints;
+	uint64_t hint_populated;
+	uint64_t hint_dropped;
+	/* bucatile aduse din sursa de origine in store-ul de bucati */
+	uint64_t chunks_fetched;
+	/* timpul de la inceputul so_execute pana la saltul la entry point */
+	uint64_t entry_ns;
+	/*
+	 * apelurile motorului de populare, paginile mapate (in total si
+	 * maximul intr-un apel) si cele mapate direct din executabil
+	 */
+	uint64_t populate_calls;
+	uint64_t populate_pages;
+	uint64_t populate_max;
+	uint64_t populate_direct;
+	/* paginile populate eager si timpul total al popularii */
+	uint64_t eager_pages;
+	uint64_t eager_ns;
+	/* numarul de pagini din fisier care nu au fost citite (doar zero) */
+	uint64_t zero_skipped;
+	/* numarul de pagini verificate si timpul petrecut in verificare */
+	uint64_t verified;
+	uint64_t verify_ns;
+	/* numarul maxim de VMA-uri (linii din /proc/self/maps) observat */
+	uint64_t vmas_max;
+	/* numarul de pagini mapate pe fiecare nod NUMA */
+	uint64_t numa_pages[NUMA_MAX_NODES];
+};
+
+/* NULL daca statisticile sunt dezactivate */
+extern struct so_stats *so_stats;
+
+/* contoarele pot fi actualizate si din thread-urile loader-ului */
+#define STATS_ADD(field, value)						\
+	do {								\
+		if (so_stats)						\
+			__atomic_fetch_add(&so_stats->field, (value),	\
+					   __ATOMIC_RELAXED);		\
+	} while (0)
+
+/* timpul curent in nanosecunde (async-signal-safe) */
+static inline uint64_t stats_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+/* aloca zona partajata pentru contoare */
+void stats_init(void);
+
+/*
+ * numara VMA-urile procesului si actualizeaza vmas_max
+ * (async-signal-safe, poate fi apelata din handler)
+ */
+void stats_sample_vmas(void);
+
+/*
+ * creeaza procesul care va executa programul; procesul curent asteapta
+ * terminarea acestuia, afiseaza statisticile (si contoarele perf, daca
+ * SO_LOADER_PERF este setat) si se termina cu acelasi cod
+ */
+void stats_watch(void);
+
+#endif /* SO_STATS_H_ */
@@ -0,0 +1,103 @@
+/*
+ * Guest symbol export for host profilers and debuggers
+ *
+ * 2018, Operating Systems
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "symexport.h"
+#include "elf_syms.h"
+#include "utils.h"
+
+/* interfata JIT a GDB (vezi "JIT Compilation Interface" in manualul GDB) */
+typedef enum {
+	JIT_NOACTION = 0,
+	JIT_REGISTER_FN,
+	JIT_UNREGISTER_FN
+} jit_actions_t;
+
+struct jit_code_entry {
+	struct jit_code_entry *next_entry;
+	struct jit_code_entry *prev_entry;
+	const char *symfile_addr;
+	uint64_t symfile_size;
+};
+
+struct jit_descriptor {
+	uint32_t version;
+	/* jit_actions_t */
+	uint32_t action_flag;
+	struct jit_code_entry *relevant_entry;
+	struct jit_code_entry *first_entry;
+};
+
+/* GDB pune un breakpoint pe aceasta functie */
+void __attribute__((noinline)) __jit_debug_register_code(void)
+{
+	asm volatile("" ::: "memory");
+}
+
+struct jit_descriptor __jit_debug_descriptor = { 1, JIT_NOACTION, NULL, NULL };
+
+void symexport_perf_map(int fd)
+{
+	struct elf_syms syms;
+	char path[64];
+	FILE *file;
+	int i;
+
+	if (elf_syms_read(fd, &syms) < 0)
+		return;
+
+	snprintf(path, sizeof(path), "/tmp/perf-%d.map", getpid());
+	file = fopen(path, "w");
+	if (file) {
+		for (i = 0; i < syms.count; i++)
+			fprintf(file, "%lx %x %s\n",
+				(unsigned long)syms.syms[i].addr,
+				syms.syms[i].size ? syms.syms[i].size : 1,
+				syms.syms[i].name);
+		fclose(file);
+	}
+
+	elf_syms_free(&syms);
+}
+
+void symexport_gdb_jit(int fd)
+{
+	static struct jit_code_entry entry;
+	struct stat st;
+	char *image;
+	ssize_t ret;
+	off_t done;
+
+	if (fstat(fd, &st) < 0 || st.st_size == 0)
+		return;
+
+	/* GDB citeste obiectul simbolic din memoria procesului */
+	image = malloc(st.st_size);
+	DIE(!image, "malloc failed.");
+
+	for (done = 0; done < st.st_size; done += ret) {
+		ret = pread(fd, image + done, st.st_size - done, done);
+		if (ret <= 0) {
+			free(image);
+			return;
+		}
+	}
+
+	entry.symfile_addr = image;
+	entry.symfile_size = st.st_size;
+	entry.next_entry = __jit_debug_descriptor.first_entry;
+	if (entry.next_entry)
+		entry.next_entry->prev_entry = &entry;
+
+	__jit_debug_descriptor.first_entry = &entry;
+	__jit_debug_descriptor.relevant_entry = &entry;
+	__jit_debug_descriptor.action_flag = JIT_REGISTER_FN;
+	__jit_debug_register_code();
+}
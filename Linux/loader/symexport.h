@@ -0,0 +1,22 @@
+/*
+ * Guest symbol export for host profilers and debuggers
+ *
+ * 2018, Operating Systems
+ */
+
+#ifndef SO_SYMEXPORT_H_
+#define SO_SYMEXPORT_H_
+
+/*
+ * scrie /tmp/perf-<pid>.map cu simbolurile de tip functie ale
+ * executabilului (citite din fisier, fara a accesa paginile mapate)
+ */
+void symexport_perf_map(int fd);
+
+/*
+ * inregistreaza imaginea executabilului prin interfata JIT a GDB, astfel
+ * incat debugger-ul sa gaseasca simbolurile programului incarcat
+ */
+void symexport_gdb_jit(int fd);
+
+#endif /* SO_SYMEXPORT_H_ */
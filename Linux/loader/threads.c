@@ -0,0 +1,141 @@
+/*
+ * Loader background threads
+ *
+ * 2018, Operating Systems
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <fcntl.h>
+#include <stdlib.h>
+
+#include "threads.h"
+#include "utils.h"
+
+/* intervalul la care se verifica starea thread-ului principal */
+#define REAPER_INTERVAL_US	10000
+
+/* tid-ul thread-ului care executa programul */
+static pid_t main_tid;
+
+/* starea comuna a unui loader_parallel_for */
+struct parallel_for {
+	void (*fn)(int task, void *arg);
+	void *arg;
+	int tasks;
+	/* urmatorul task neatribuit */
+	int next;
+};
+
+/*
+ * citeste starea thread-ului principal din /proc; intoarce 1 daca acesta
+ * s-a terminat (si codul de iesire in *code)
+ */
+static int main_thread_exited(int *code)
+{
+	char path[64], buf[1024], *p;
+	int fd, len, field;
+
+	snprintf(path, sizeof(path), "/proc/self/task/%d/stat", main_tid);
+	fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		*code = 0;
+		return 1;
+	}
+
+	len = read(fd, buf, sizeof(buf) - 1);
+	close(fd);
+	if (len <= 0)
+		return 0;
+	buf[len] = '\0';
+
+	/* dupa numele thread-ului (intre paranteze) urmeaza starea */
+	p = strrchr(buf, ')');
+	if (!p || p[1] != ' ' || p[2] != 'Z')
+		return 0;
+
+	/* ultimul camp (52) este exit_code, in formatul lui waitpid */
+	*code = 0;
+	for (field = 2; p && field < 52; field++)
+		p = strchr(p + 1, ' ');
+	if (p)
+		*code = (atoi(p + 1) >> 8) & 0xff;
+
+	return 1;
+}
+
+static void *reaper(void *arg)
+{
+	int code;
+
+	while (!main_thread_exited(&code))
+		usleep(REAPER_INTERVAL_US);
+
+	syscall(SYS_exit_group, code);
+	return NULL;
+}
+
+static void start_detached(void *(*fn)(void *), void *arg)
+{
+	pthread_attr_t attr;
+	pthread_t thread;
+	int ret;
+
+	pthread_attr_init(&attr);
+	pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+	ret = pthread_create(&thread, &attr, fn, arg);
+	DIE(ret != 0, "pthread_create failed.");
+	pthread_attr_destroy(&attr);
+}
+
+void loader_thread_start(void *(*fn)(void *), void *arg)
+{
+	if (!main_tid) {
+		main_tid = syscall(SYS_gettid);
+		start_detached(reaper, NULL);
+	}
+
+	start_detached(fn, arg);
+}
+
+static void *parallel_worker(void *arg)
+{
+	struct parallel_for *pf = arg;
+	int task;
+
+	while ((task = __atomic_fetch_add(&pf->next, 1, __ATOMIC_RELAXED))
+	       < pf->tasks)
+		pf->fn(task, pf->arg);
+
+	return NULL;
+}
+
+void loader_parallel_for(int tasks, int threads_no,
+			 void (*fn)(int task, void *arg), void *arg)
+{
+	struct parallel_for pf = { fn, arg, tasks, 0 };
+	pthread_t *threads;
+	int i, ret;
+
+	if (threads_no > tasks)
+		threads_no = tasks;
+	if (threads_no < 1)
+		threads_no = 1;
+
+	threads = malloc(threads_no * sizeof(pthread_t));
+	DIE(!threads, "malloc failed.");
+
+	for (i = 1; i < threads_no; i++) {
+		ret = pthread_create(&threads[i], NULL, parallel_worker, &pf);
+		DIE(ret != 0, "pthread_create failed.");
+	}
+
+	parallel_worker(&pf);
+
+	for (i = 1; i < threads_no; i++)
+		pthread_join(threads[i], NULL);
+	free(threads);
+}
@@ -0,0 +1,27 @@
+/*
+ * Loader background threads
+ *
+ * 2018, Operating Systems
+ */
+
+#ifndef SO_THREADS_H_
+#define SO_THREADS_H_
+
+/*
+ * porneste un thread (detasat) al loader-ului.
+ * Programul incarcat se poate termina cu apelul de sistem exit (nu
+ * exit_group), care opreste doar thread-ul principal; la primul apel se
+ * porneste si un thread care observa terminarea thread-ului principal si
+ * termina tot procesul, cu acelasi cod de iesire.
+ */
+void loader_thread_start(void *(*fn)(void *), void *arg);
+
+/*
+ * executa fn(task, arg) pentru task = 0 .. tasks - 1 pe un grup de
+ * threads_no thread-uri (inclusiv cel curent); se intoarce dupa ce toate
+ * task-urile au fost executate
+ */
+void loader_parallel_for(int tasks, int threads_no,
+			 void (*fn)(int task, void *arg), void *arg);
+
+#endif /* SO_THREADS_H_ */
@@ -0,0 +1,80 @@
+/*
+ * Page fault trace recording
+ *
+ * 2018, Operating Systems
+ */
+
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+
+#include "trace.h"
+#include "stats.h"
+
+/*
+ * fisierul este mapat partajat, astfel incat intrarile ajung in fisier
+ * chiar daca programul se termina fara a mai reveni in loader
+ */
+static struct trace_hdr *trace;
+static struct trace_entry *entries;
+static uint64_t start_ns;
+
+int trace_open(const char *path)
+{
+	size_t size = sizeof(*trace) +
+		      TRACE_CAPACITY * sizeof(struct trace_entry);
+	void *map;
+	int fd;
+
+	fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0)
+		return -1;
+
+	if (ftruncate(fd, size) < 0) {
+		close(fd);
+		return -1;
+	}
+
+	map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED)
+		return -1;
+
+	trace = map;
+	trace->magic = TRACE_MAGIC;
+	trace->version = TRACE_VERSION;
+	trace->hdr_size = sizeof(*trace);
+	trace->page_size = getpagesize();
+	trace->capacity = TRACE_CAPACITY;
+	trace->count = 0;
+	trace->entry_ns = 0;
+	entries = (struct trace_entry *)(trace + 1);
+	start_ns = stats_now();
+
+	return 0;
+}
+
+void trace_record(uintptr_t addr)
+{
+	uint64_t count;
+
+	if (!trace)
+		return;
+
+	count = __atomic_load_n(&trace->count, __ATOMIC_RELAXED);
+	if (count >= trace->capacity)
+		return;
+
+	entries[count].time_ns = stats_now() - start_ns;
+	entries[count].addr = addr;
+	__atomic_store_n(&trace->count, count + 1, __ATOMIC_RELEASE);
+}
+
+void trace_mark_entry(void)
+{
+	if (trace)
+		trace->entry_ns = stats_now() - start_ns;
+}
@@ -0,0 +1,52 @@
+/*
+ * Page fault trace recording
+ *
+ * 2018, Operating Systems
+ */
+
+#ifndef SO_TRACE_H_
+#define SO_TRACE_H_
+
+#include <stdint.h>
+
+#define TRACE_MAGIC	0x52544f53	/* "SOTR" */
+#define TRACE_VERSION	2
+
+/* capacitatea implicita a unei urme (numar de page fault-uri) */
+#define TRACE_CAPACITY	(1 << 20)
+
+/*
+ * formatul fisierului: antetul, urmat de capacity intrari, dintre care
+ * primele count sunt valide (in ordinea page fault-urilor)
+ */
+struct trace_hdr {
+	uint32_t magic;
+	uint16_t version;
+	uint16_t hdr_size;
+	uint32_t page_size;
+	uint32_t capacity;
+	uint64_t count;
+	/* momentul saltului la entry point (0 daca nu a avut loc) */
+	uint64_t entry_ns;
+};
+
+struct trace_entry {
+	/* momentul page fault-ului, relativ la inceputul urmei */
+	uint64_t time_ns;
+	/* adresa care a generat page fault-ul */
+	uint64_t addr;
+};
+
+/* creeaza fisierul urmei; intoarce 0 sau -1 */
+int trace_open(const char *path);
+
+/*
+ * adauga o intrare (async-signal-safe); intrarile care nu mai incap sunt
+ * ignorate
+ */
+void trace_record(uintptr_t addr);
+
+/* noteaza in antet momentul saltului la entry point */
+void trace_mark_entry(void);
+
+#endif /* SO_TRACE_H_ */
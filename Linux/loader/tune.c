@@ -0,0 +1,189 @@
+/*
+ * Loading policy autotuner
+ *
+ * 2018, Operating Systems
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <fcntl.h>
+
+#include "tune.h"
+#include "config.h"
+#include "stats.h"
+#include "utils.h"
+
+/* configuratiile incercate (eager face fault-around-ul inutil) */
+static const struct tune_config candidates[] = {
+	{ 1, 0, 0, 0 },
+	{ 4, 0, 0, 0 },
+	{ 16, 0, 0, 0 },
+	{ 1, 0, 1, 0 },
+	{ 4, 0, 1, 0 },
+	{ 16, 0, 1, 0 },
+	{ 1, 1, 0, 0 },
+	{ 1, 1, 1, 0 },
+};
+
+#define CANDIDATES_NO	(sizeof(candidates) / sizeof(candidates[0]))
+
+/* masuratorile medii ale unei configuratii */
+struct tune_result {
+	uint64_t wall_ns;
+	uint64_t entry_ns;
+	uint64_t faults;
+	long rss_kb;
+	int failed;
+};
+
+/* setat in procesele copil, unde configuratia candidat nu se schimba */
+static int tuning;
+
+/*
+ * codul de iesire al primei rulari (prima configuratie, cea implicita);
+ * o configuratie cu care programul iese cu alt cod a esuat, chiar daca
+ * (sau tocmai pentru ca) s-a terminat mai repede
+ */
+static int baseline_exit = -1;
+
+static void tune_set(const struct tune_config *tc)
+{
+	so_cfg.fault_around = tc->fault_around;
+	so_cfg.eager = tc->eager;
+	so_cfg.prefault = tc->prefault;
+}
+
+void tune_apply(const struct stat *st)
+{
+	struct tune_config *tc;
+	size_t len;
+
+	if (tuning)
+		return;
+
+	tc = cache_blob_map(st, CACHE_KIND_TUNE, &len);
+	if (!tc)
+		return;
+
+	if (len == sizeof(*tc)) {
+		if (!config_is_set("SO_LOADER_FAULT_AROUND") &&
+		    tc->fault_around > 0)
+			so_cfg.fault_around = tc->fault_around;
+		if (!config_is_set("SO_LOADER_EAGER"))
+			so_cfg.eager = tc->eager;
+		if (!config_is_set("SO_LOADER_PREFAULT"))
+			so_cfg.prefault = tc->prefault;
+	}
+
+	cache_blob_unmap(tc, len);
+}
+
+/* o singura rulare; intoarce 0 in procesul copil */
+static int tune_once(const struct tune_config *tc, struct tune_result *res)
+{
+	struct rusage usage;
+	uint64_t start;
+	pid_t pid;
+	int status, fd;
+
+	memset(so_stats, 0, sizeof(*so_stats));
+	start = stats_now();
+
+	pid = fork();
+	DIE(pid < 0, "fork failed.");
+	if (pid == 0) {
+		tuning = 1;
+		so_cfg.autotune = 0;
+		so_cfg.stats = 0;
+		so_cfg.perf = 0;
+		tune_set(tc);
+
+		/* iesirea programului nu intereseaza in timpul masuratorilor */
+		fd = open("/dev/null", O_WRONLY);
+		if (fd >= 0) {
+			dup2(fd, STDOUT_FILENO);
+			close(fd);
+		}
+		return 0;
+	}
+
+	DIE(wait4(pid, &status, 0, &usage) < 0, "wait4 failed.");
+
+	res->wall_ns += stats_now() - start;
+	res->entry_ns += so_stats->entry_ns;
+	res->faults += so_stats->faults;
+	res->rss_kb += usage.ru_maxrss;
+	if (!WIFEXITED(status))
+		res->failed = 1;
+	else if (baseline_exit < 0)
+		baseline_exit = WEXITSTATUS(status);
+	else if (WEXITSTATUS(status) != baseline_exit)
+		res->failed = 1;
+
+	return 1;
+}
+
+void tune_run(const char *path)
+{
+	struct tune_result results[CANDIDATES_NO];
+	struct stat st;
+	unsigned int i, best = 0;
+	int runs = so_cfg.autotune, j;
+
+	if (stat(path, &st) < 0 || !S_ISREG(st.st_mode)) {
+		fprintf(stderr, "so_loader: autotune needs a regular file\n");
+		exit(1);
+	}
+
+	memset(results, 0, sizeof(results));
+	for (i = 0; i < CANDIDATES_NO; i++) {
+		for (j = 0; j < runs; j++)
+			if (!tune_once(&candidates[i], &results[i]))
+				return;
+
+		results[i].wall_ns /= runs;
+		results[i].entry_ns /= runs;
+		results[i].faults /= runs;
+		results[i].rss_kb /= runs;
+
+		fprintf(stderr, "so_loader: tune fault_around=%d eager=%d "
+			"prefault=%d wall_us=%llu entry_us=%llu faults=%llu "
+			"rss_kb=%ld%s\n",
+			candidates[i].fault_around, candidates[i].eager,
+			candidates[i].prefault,
+			(unsigned long long)(results[i].wall_ns / 1000),
+			(unsigned long long)(results[i].entry_ns / 1000),
+			(unsigned long long)results[i].faults,
+			results[i].rss_kb, results[i].failed ? " failed" : "");
+
+		/* configuratiile cu care programul esueaza nu sunt alese */
+		if (results[best].failed ||
+		    (!results[i].failed &&
+		     results[i].wall_ns < results[best].wall_ns))
+			best = i;
+	}
+
+	if (results[best].failed) {
+		fprintf(stderr, "so_loader: autotune failed\n");
+		exit(1);
+	}
+
+	fprintf(stderr, "so_loader: tune best fault_around=%d eager=%d "
+		"prefault=%d\n", candidates[best].fault_around,
+		candidates[best].eager, candidates[best].prefault);
+
+	if (!so_cfg.cache_dir)
+		fprintf(stderr, "so_loader: SO_LOADER_CACHE_DIR is not set, "
+			"the result is not saved\n");
+	else if (cache_blob_store(&st, CACHE_KIND_TUNE, &candidates[best],
+				  sizeof(candidates[best])) < 0)
+		perror("cache_blob_store");
+
+	exit(0);
+}
@@ -0,0 +1,39 @@
+/*
+ * Loading policy autotuner
+ *
+ * 2018, Operating Systems
+ */
+
+#ifndef SO_TUNE_H_
+#define SO_TUNE_H_
+
+#include <stdint.h>
+#include <sys/stat.h>
+
+#include "plan_cache.h"
+
+#define CACHE_KIND_TUNE	CACHE_KIND('t', 'u', 'n', 'e')
+
+/* configuratia salvata in cache pentru un executabil */
+struct tune_config {
+	int32_t fault_around;
+	int32_t eager;
+	int32_t prefault;
+	int32_t reserved;
+};
+
+/*
+ * aplica configuratia salvata de autotuner pentru executabilul descris de
+ * st; optiunile setate explicit in mediu au prioritate
+ */
+void tune_apply(const struct stat *st);
+
+/*
+ * ruleaza executabilul de SO_LOADER_AUTOTUNE ori cu fiecare configuratie
+ * candidat, afiseaza masuratorile, salveaza cea mai rapida configuratie si
+ * termina procesul; revine doar in procesele copil, care continua executia
+ * cu configuratia candidat
+ */
+void tune_run(const char *path);
+
+#endif /* SO_TUNE_H_ */
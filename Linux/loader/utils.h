@@ -15,17 +15,4 @@
 		}							\
 	} while (0)
 
-#define ERR_AP	0.0000000001f
-
-/* echivalentul functiei ceil din libraria math.h */
-static int ceil_(float x)
-{
-	int x_int = (int)x;
-
-	if (x - x_int < ERR_AP)
-		return x_int;
-
-	return x_int + 1;
-}
-
 #endif
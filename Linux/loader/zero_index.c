@@ -0,0 +1,191 @@
+/*
+ * Index of all-zero file pages
+ *
+ * 2018, Operating Systems
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#if defined(__i386__) || defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+#include "zero_index.h"
+#include "utils.h"
+
+/* dimensiunea zonei citite o data din fisier */
+#define SCAN_CHUNK	(1 << 20)
+
+/* bitmap-ul fiecarui segment (un bit pentru fiecare pagina) */
+static uint8_t **seg_bitmaps;
+
+/* toate bitmap-urile, intr-o singura zona (formatul din cache) */
+static uint8_t *bitmaps;
+
+static int (*is_zero)(const void *buf, size_t len);
+
+static int is_zero_generic(const void *buf, size_t len)
+{
+	const unsigned char *p = buf;
+	unsigned long acc = 0, word;
+
+	for (; len >= sizeof(word); len -= sizeof(word), p += sizeof(word)) {
+		memcpy(&word, p, sizeof(word));
+		acc |= word;
+	}
+	while (len--)
+		acc |= *p++;
+
+	return acc == 0;
+}
+
+#if defined(__i386__) || defined(__x86_64__)
+__attribute__((target("sse2")))
+static int is_zero_sse2(const void *buf, size_t len)
+{
+	const char *p = buf;
+	__m128i acc = _mm_setzero_si128();
+
+	for (; len >= 64; len -= 64, p += 64) {
+		acc = _mm_or_si128(acc, _mm_loadu_si128((const __m128i *)p));
+		acc = _mm_or_si128(acc,
+				   _mm_loadu_si128((const __m128i *)(p + 16)));
+		acc = _mm_or_si128(acc,
+				   _mm_loadu_si128((const __m128i *)(p + 32)));
+		acc = _mm_or_si128(acc,
+				   _mm_loadu_si128((const __m128i *)(p + 48)));
+	}
+
+	if (_mm_movemask_epi8(_mm_cmpeq_epi8(acc, _mm_setzero_si128()))
+	    != 0xffff)
+		return 0;
+
+	return is_zero_generic(p, len);
+}
+
+__attribute__((target("avx2")))
+static int is_zero_avx2(const void *buf, size_t len)
+{
+	const char *p = buf;
+	__m256i acc = _mm256_setzero_si256();
+
+	for (; len >= 128; len -= 128, p += 128) {
+		acc = _mm256_or_si256(acc,
+				_mm256_loadu_si256((const __m256i *)p));
+		acc = _mm256_or_si256(acc,
+				_mm256_loadu_si256((const __m256i *)(p + 32)));
+		acc = _mm256_or_si256(acc,
+				_mm256_loadu_si256((const __m256i *)(p + 64)));
+		acc = _mm256_or_si256(acc,
+				_mm256_loadu_si256((const __m256i *)(p + 96)));
+	}
+
+	if (!_mm256_testz_si256(acc, acc))
+		return 0;
+
+	return is_zero_generic(p, len);
+}
+#endif
+
+static void select_scanner(void)
+{
+	is_zero = is_zero_generic;
+#if defined(__i386__) || defined(__x86_64__)
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+		is_zero = is_zero_avx2;
+	else if (__builtin_cpu_supports("sse2"))
+		is_zero = is_zero_sse2;
+#endif
+}
+
+/* dimensiunea (in bytes) a bitmap-ului unui segment */
+static size_t bitmap_size(unsigned int pages)
+{
+	return (pages + 7) / 8;
+}
+
+/* scaneaza paginile cu date din fisier ale segmentului */
+static void scan_segment(so_seg_t *seg, int fd, uint8_t *bitmap, char *buf)
+{
+	unsigned int page_size = getpagesize();
+	unsigned int pos, len, done, page;
+	ssize_t ret;
+
+	for (pos = 0; pos < seg->file_size; pos += len) {
+		len = seg->file_size - pos;
+		if (len > SCAN_CHUNK)
+			len = SCAN_CHUNK;
+
+		for (done = 0; done < len; done += ret) {
+			ret = pread(fd, buf + done, len - done,
+				    seg->offset + pos + done);
+			if (ret <= 0)
+				return;
+		}
+
+		/* SCAN_CHUNK este multiplu de dimensiunea paginii */
+		for (done = 0; done < len; done += page_size) {
+			page = (pos + done) / page_size;
+			if (is_zero(buf + done, len - done < page_size ?
+				    len - done : page_size))
+				bitmap[page / 8] |= 1 << (page % 8);
+		}
+	}
+}
+
+void zero_index_build(so_exec_t *exec, const unsigned int *pages_no, int fd,
+		      const struct stat *key)
+{
+	size_t total = 0, len;
+	void *cached = NULL;
+	char *buf;
+	int i;
+
+	for (i = 0; i < exec->segments_no; i++)
+		total += bitmap_size(pages_no[i]);
+
+	if (key) {
+		cached = cache_blob_map(key, CACHE_KIND_ZERO, &len);
+		if (cached && len != total) {
+			cache_blob_unmap(cached, len);
+			cached = NULL;
+		}
+	}
+
+	if (cached) {
+		bitmaps = cached;
+	} else {
+		bitmaps = calloc(total + 1, 1);
+		buf = malloc(SCAN_CHUNK);
+		DIE(!bitmaps || !buf, "malloc failed.");
+
+		select_scanner();
+		for (i = 0, len = 0; i < exec->segments_no; i++) {
+			scan_segment(&exec->segments[i], fd, bitmaps + len,
+				     buf);
+			len += bitmap_size(pages_no[i]);
+		}
+		free(buf);
+
+		if (key)
+			cache_blob_store(key, CACHE_KIND_ZERO, bitmaps, total);
+	}
+
+	seg_bitmaps = malloc(exec->segments_no * sizeof(uint8_t *));
+	DIE(!seg_bitmaps, "malloc failed.");
+	for (i = 0, len = 0; i < exec->segments_no; i++) {
+		seg_bitmaps[i] = bitmaps + len;
+		len += bitmap_size(pages_no[i]);
+	}
+}
+
+int zero_index_test(int seg_index, int page_index)
+{
+	if (!seg_bitmaps)
+		return 0;
+
+	return seg_bitmaps[seg_index][page_index / 8] &
+		(1 << (page_index % 8));
+}
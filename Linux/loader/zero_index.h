@@ -0,0 +1,30 @@
+/*
+ * Index of all-zero file pages
+ *
+ * 2018, Operating Systems
+ */
+
+#ifndef SO_ZERO_INDEX_H_
+#define SO_ZERO_INDEX_H_
+
+#include <sys/stat.h>
+
+#include "exec_parser.h"
+#include "plan_cache.h"
+
+#define CACHE_KIND_ZERO	CACHE_KIND('z', 'e', 'r', 'o')
+
+/*
+ * construieste (sau incarca din cache, daca key este nenul) indexul
+ * paginilor ale caror date din fisier sunt toate zero
+ */
+void zero_index_build(so_exec_t *exec, const unsigned int *pages_no, int fd,
+		      const struct stat *key);
+
+/*
+ * intoarce 1 daca datele din fisier ale paginii sunt toate zero (pagina
+ * poate fi tratata ca .bss, fara citire)
+ */
+int zero_index_test(int seg_index, int page_index);
+
+#endif /* SO_ZERO_INDEX_H_ */
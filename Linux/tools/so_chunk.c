@@ -0,0 +1,88 @@
+/*
+ * Content-addressed chunk store ingestion
+ *
+ * 2018, Operating Systems
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+
+#include "chunk_store.h"
+#include "utils.h"
+
+int main(int argc, char *argv[])
+{
+	struct chunk_recipe_hdr hdr;
+	struct chunk_id id;
+	char out_path[4096];
+	unsigned int added = 0, i;
+	struct stat st;
+	ssize_t ret;
+	size_t len;
+	FILE *out;
+	char *buf;
+	int fd, res;
+
+	if (argc < 3) {
+		fprintf(stderr, "Usage: %s <store> <executable> [recipe]\n",
+			argv[0]);
+		return 1;
+	}
+
+	fd = open(argv[2], O_RDONLY);
+	DIE(fd < 0, "open failed");
+	DIE(fstat(fd, &st) < 0, "fstat failed");
+	DIE(mkdir(argv[1], 0755) < 0 && errno != EEXIST, "mkdir failed");
+
+	if (argc > 3)
+		snprintf(out_path, sizeof(out_path), "%s", argv[3]);
+	else
+		snprintf(out_path, sizeof(out_path), "%s.recipe", argv[2]);
+
+	out = fopen(out_path, "wb");
+	DIE(!out, "fopen failed");
+
+	/* bucatile au dimensiunea paginii: un page fault citeste o bucata */
+	memset(&hdr, 0, sizeof(hdr));
+	hdr.magic = CHUNK_RECIPE_MAGIC;
+	hdr.version = CHUNK_RECIPE_VERSION;
+	hdr.hdr_size = sizeof(hdr);
+	hdr.chunk_size = getpagesize();
+	hdr.chunks_no = (st.st_size + hdr.chunk_size - 1) / hdr.chunk_size;
+	hdr.file_size = st.st_size;
+	DIE(fwrite(&hdr, sizeof(hdr), 1, out) != 1, "fwrite failed");
+
+	buf = malloc(hdr.chunk_size);
+	DIE(!buf, "malloc failed");
+
+	/* doar bucatile noi sunt scrise in store */
+	for (i = 0; i < hdr.chunks_no; i++) {
+		len = st.st_size - (off_t)i * hdr.chunk_size;
+		if (len > hdr.chunk_size)
+			len = hdr.chunk_size;
+
+		ret = pread(fd, buf, len, (off_t)i * hdr.chunk_size);
+		DIE(ret != (ssize_t)len, "pread failed");
+
+		chunk_hash(buf, len, &id);
+		res = chunk_store_put(argv[1], &id, buf, len);
+		DIE(res < 0, "chunk_store_put failed");
+		added += res;
+
+		DIE(fwrite(&id, sizeof(id), 1, out) != 1, "fwrite failed");
+	}
+
+	DIE(fclose(out) != 0, "fclose failed");
+	close(fd);
+	free(buf);
+
+	printf("%s: %u chunks, %u new, %u already in %s\n", out_path,
+	       hdr.chunks_no, added, hdr.chunks_no - added, argv[1]);
+
+	return 0;
+}
@@ -0,0 +1,310 @@
+/*
+ * Offline fault-trace simulator
+ *
+ * 2018, Operating Systems
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "exec_parser.h"
+#include "trace.h"
+#include "utils.h"
+
+/* fereastra maxima a politicii adaptive */
+#define ADAPTIVE_MAX	32
+/* numarul de pagini aduse in avans de politica stride */
+#define STRIDE_DEPTH	4
+
+/* starea unei pagini in simulare */
+#define PAGE_ABSENT	0
+#define PAGE_PREFETCHED	1
+#define PAGE_USED	2
+
+struct policy {
+	const char *name;
+	/* fereastra fixa de fault-around (1 = doar pagina accesata) */
+	int window;
+	/* fereastra se dubleaza la page fault-uri secventiale */
+	int adaptive;
+	/* se aduc paginile urmatoare cu pasul ultimelor doua fault-uri */
+	int stride;
+};
+
+static const struct policy policies[] = {
+	{ "one-page", 1, 0, 0 },
+	{ "fault-around-4", 4, 0, 0 },
+	{ "fault-around-16", 16, 0, 0 },
+	{ "adaptive", 1, 1, 0 },
+	{ "stride", 1, 0, 1 },
+};
+
+#define POLICIES_NO	(sizeof(policies) / sizeof(policies[0]))
+
+struct result {
+	uint64_t faults;
+	uint64_t bytes_read;
+	uint64_t prefetched;
+	uint64_t wasted;
+	uint64_t evicted;
+	uint64_t peak_resident;
+};
+
+static so_exec_t *exec;
+static uint64_t entry_ns;
+static unsigned int *first_page;
+static unsigned int total_pages;
+static int page_size;
+
+/* paginile simulate si ordinea in care au fost mapate (pentru evacuare) */
+static uint8_t *state;
+static unsigned int *fifo;
+static unsigned int fifo_head, fifo_tail;
+static uint64_t resident;
+
+static struct trace_entry *entries;
+static uint64_t entries_no;
+
+static int segment_of(uint64_t addr)
+{
+	int i;
+
+	for (i = 0; i < exec->segments_no; i++)
+		if (addr >= exec->segments[i].vaddr &&
+		    addr < exec->segments[i].vaddr + exec->segments[i].mem_size)
+			return i;
+
+	return -1;
+}
+
+/* numarul de bytes cititi din fisier pentru pagina page a segmentului */
+static unsigned int page_bytes(int seg, unsigned int page)
+{
+	unsigned int start = page * page_size;
+	unsigned int file_size = exec->segments[seg].file_size;
+
+	if (start >= file_size)
+		return 0;
+
+	return file_size - start < (unsigned int)page_size ?
+	       file_size - start : (unsigned int)page_size;
+}
+
+static void evict_one(struct result *res)
+{
+	unsigned int page;
+
+	while (fifo_tail != fifo_head) {
+		page = fifo[fifo_tail++ % total_pages];
+		if (state[page] == PAGE_ABSENT)
+			continue;
+
+		if (state[page] == PAGE_PREFETCHED)
+			res->wasted++;
+		state[page] = PAGE_ABSENT;
+		resident--;
+		res->evicted++;
+		return;
+	}
+}
+
+/* mapeaza pagina page a segmentului (daca nu este deja mapata) */
+static void map(int seg, long page, int prefetch, uint64_t cap,
+		struct result *res)
+{
+	unsigned int index;
+
+	if (page < 0 || page >= (long)(first_page[seg + 1] - first_page[seg]))
+		return;
+
+	index = first_page[seg] + page;
+	if (state[index] != PAGE_ABSENT)
+		return;
+
+	if (cap && resident >= cap)
+		evict_one(res);
+
+	state[index] = prefetch ? PAGE_PREFETCHED : PAGE_USED;
+	fifo[fifo_head++ % total_pages] = index;
+	resident++;
+	if (resident > res->peak_resident)
+		res->peak_resident = resident;
+
+	res->bytes_read += page_bytes(seg, page);
+	if (prefetch)
+		res->prefetched++;
+}
+
+static void simulate(const struct policy *pol, uint64_t cap,
+		     struct result *res)
+{
+	long page, last_page = -1, last_stride = 0, next_seq = -1;
+	int seg, last_seg = -1, window = 1, i;
+	unsigned int index;
+	uint64_t e;
+
+	memset(res, 0, sizeof(*res));
+	memset(state, PAGE_ABSENT, total_pages);
+	fifo_head = fifo_tail = 0;
+	resident = 0;
+
+	for (e = 0; e < entries_no; e++) {
+		seg = segment_of(entries[e].addr);
+		if (seg < 0)
+			continue;
+
+		page = (entries[e].addr - exec->segments[seg].vaddr) /
+		       page_size;
+		index = first_page[seg] + page;
+
+		if (state[index] != PAGE_ABSENT) {
+			state[index] = PAGE_USED;
+			continue;
+		}
+
+		res->faults++;
+		map(seg, page, 0, cap, res);
+
+		if (pol->adaptive) {
+			/* accesul continua exact dupa fereastra anterioara */
+			if (seg == last_seg && page == next_seq)
+				window = window * 2 > ADAPTIVE_MAX ?
+					 ADAPTIVE_MAX : window * 2;
+			else
+				window = 1;
+		} else {
+			window = pol->window;
+		}
+
+		for (i = 1; i < window; i++)
+			map(seg, page + i, 1, cap, res);
+		next_seq = page + window;
+
+		if (pol->stride && seg == last_seg &&
+		    page - last_page == last_stride && last_stride != 0)
+			for (i = 1; i <= STRIDE_DEPTH; i++)
+				map(seg, page + i * last_stride, 1, cap, res);
+
+		if (seg == last_seg)
+			last_stride = page - last_page;
+		last_seg = seg;
+		last_page = page;
+	}
+
+	for (index = 0; index < total_pages; index++)
+		if (state[index] == PAGE_PREFETCHED)
+			res->wasted++;
+}
+
+static void load_trace(const char *path)
+{
+	struct trace_hdr hdr;
+	FILE *in;
+
+	in = fopen(path, "rb");
+	DIE(!in, "fopen failed");
+	DIE(fread(&hdr, sizeof(hdr), 1, in) != 1, "fread failed");
+	if (hdr.magic != TRACE_MAGIC || hdr.version != TRACE_VERSION ||
+	    hdr.hdr_size != sizeof(hdr) ||
+	    hdr.page_size != (uint32_t)page_size) {
+		fprintf(stderr, "%s: invalid trace\n", path);
+		exit(1);
+	}
+
+	entries_no = hdr.count;
+	entry_ns = hdr.entry_ns;
+	entries = malloc(entries_no * sizeof(*entries) + 1);
+	DIE(!entries, "malloc failed");
+	DIE(fread(entries, sizeof(*entries), entries_no, in) != entries_no,
+	    "fread failed");
+	fclose(in);
+}
+
+/*
+ * prima instructiune a programului se executa la saltul la entry point,
+ * daca pagina entry point-ului era deja mapata, sau dupa page fault-ul
+ * ei (intrarea este adaugata dupa maparea paginii)
+ */
+static void print_entry(void)
+{
+	uint64_t page = exec->entry / page_size;
+	uint64_t first_ns = entry_ns;
+	uint64_t i;
+
+	if (!entry_ns)
+		return;
+
+	for (i = 0; i < entries_no; i++)
+		if (entries[i].addr / page_size == page &&
+		    entries[i].time_ns >= entry_ns) {
+			first_ns = entries[i].time_ns;
+			break;
+		}
+
+	printf("entry: jump at %llu us, first instruction at %llu us\n",
+	       (unsigned long long)(entry_ns / 1000),
+	       (unsigned long long)(first_ns / 1000));
+}
+
+int main(int argc, char *argv[])
+{
+	struct result res;
+	uint64_t cap = 0;
+	unsigned int i;
+	int j;
+
+	if (argc < 3) {
+		fprintf(stderr, "Usage: %s <executable> <trace> "
+			"[rss_cap_pages]\n", argv[0]);
+		return 1;
+	}
+
+	exec = so_parse_exec(argv[1]);
+	if (!exec)
+		return 1;
+
+	page_size = getpagesize();
+	load_trace(argv[2]);
+	if (argc > 3)
+		cap = strtoull(argv[3], NULL, 0);
+
+	/* paginile tuturor segmentelor sunt numerotate consecutiv */
+	first_page = malloc((exec->segments_no + 1) * sizeof(*first_page));
+	DIE(!first_page, "malloc failed");
+	first_page[0] = 0;
+	for (j = 0; j < exec->segments_no; j++)
+		first_page[j + 1] = first_page[j] +
+			ALIGN_UP(exec->segments[j].mem_size, page_size) /
+			page_size;
+	total_pages = first_page[exec->segments_no];
+
+	state = malloc(total_pages + 1);
+	fifo = malloc((total_pages + 1) * sizeof(*fifo));
+	DIE(!state || !fifo, "malloc failed");
+
+	printf("trace: %llu faults over %llu us, %u pages in %d segments\n",
+	       (unsigned long long)entries_no,
+	       (unsigned long long)(entries_no ?
+				    entries[entries_no - 1].time_ns / 1000 : 0),
+	       total_pages, exec->segments_no);
+	print_entry();
+	printf("%-16s %8s %8s %12s %10s %8s %8s %8s\n", "policy", "rss_cap",
+	       "faults", "bytes_read", "prefetched", "wasted", "evicted",
+	       "peak");
+
+	for (i = 0; i < POLICIES_NO; i++) {
+		simulate(&policies[i], cap, &res);
+		printf("%-16s %8llu %8llu %12llu %10llu %8llu %8llu %8llu\n",
+		       policies[i].name, (unsigned long long)cap,
+		       (unsigned long long)res.faults,
+		       (unsigned long long)res.bytes_read,
+		       (unsigned long long)res.prefetched,
+		       (unsigned long long)res.wasted,
+		       (unsigned long long)res.evicted,
+		       (unsigned long long)res.peak_resident);
+	}
+
+	return 0;
+}
@@ -0,0 +1,109 @@
+/*
+ * Per-page integrity manifest generator
+ *
+ * 2018, Operating Systems
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+
+#include "exec_parser.h"
+#include "manifest.h"
+#include "crc32c.h"
+#include "utils.h"
+
+/*
+ * construieste continutul paginii page_index din segment, asa cum il
+ * mapeaza loader-ul: datele din fisier urmate de zerouri
+ */
+static void page_image(int fd, so_seg_t *seg, int page_index, char *page,
+		       int page_size)
+{
+	unsigned int start = page_index * page_size;
+	ssize_t ret;
+	int len;
+
+	memset(page, 0, page_size);
+	if (start >= seg->file_size)
+		return;
+
+	len = seg->file_size - start;
+	if (len > page_size)
+		len = page_size;
+
+	ret = pread(fd, page, len, seg->offset + start);
+	DIE(ret != len, "pread failed");
+}
+
+int main(int argc, char *argv[])
+{
+	struct manifest_hdr hdr;
+	char out_path[4096];
+	so_exec_t *exec;
+	struct stat st;
+	FILE *out;
+	char *page;
+	uint32_t pages_no, digest;
+	int page_size, fd, i, j;
+
+	if (argc < 2) {
+		fprintf(stderr, "Usage: %s <executable> [manifest]\n",
+			argv[0]);
+		return 1;
+	}
+
+	exec = so_parse_exec(argv[1]);
+	if (!exec)
+		return 1;
+
+	fd = open(argv[1], O_RDONLY);
+	DIE(fd < 0, "open failed");
+	DIE(fstat(fd, &st) < 0, "fstat failed");
+
+	if (argc > 2)
+		snprintf(out_path, sizeof(out_path), "%s", argv[2]);
+	else
+		snprintf(out_path, sizeof(out_path), "%s.manifest", argv[1]);
+
+	out = fopen(out_path, "wb");
+	DIE(!out, "fopen failed");
+
+	page_size = getpagesize();
+	page = malloc(page_size);
+	DIE(!page, "malloc failed");
+	crc32c_init();
+
+	memset(&hdr, 0, sizeof(hdr));
+	hdr.magic = MANIFEST_MAGIC;
+	hdr.version = MANIFEST_VERSION;
+	hdr.hdr_size = sizeof(hdr);
+	hdr.page_size = page_size;
+	hdr.segments_no = exec->segments_no;
+	hdr.file_size = st.st_size;
+	DIE(fwrite(&hdr, sizeof(hdr), 1, out) != 1, "fwrite failed");
+
+	for (i = 0; i < exec->segments_no; i++) {
+		pages_no = ALIGN_UP(exec->segments[i].mem_size, page_size) /
+			   page_size;
+		DIE(fwrite(&pages_no, sizeof(pages_no), 1, out) != 1,
+		    "fwrite failed");
+
+		for (j = 0; j < (int)pages_no; j++) {
+			page_image(fd, &exec->segments[i], j, page,
+				   page_size);
+			digest = crc32c(page, page_size);
+			DIE(fwrite(&digest, sizeof(digest), 1, out) != 1,
+			    "fwrite failed");
+		}
+	}
+
+	DIE(fclose(out) != 0, "fclose failed");
+	close(fd);
+	free(page);
+
+	return 0;
+}
@@ -0,0 +1,233 @@
+/*
+ * Packed image generator
+ *
+ * 2018, Operating Systems
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+
+#include "exec_parser.h"
+#include "packed.h"
+#include "trace.h"
+#include "utils.h"
+
+/* pagina nu este folosita de niciun segment */
+#define PAGE_UNUSED	0
+/* pagina contine date ale unui segment */
+#define PAGE_USED	1
+/* pagina a fost deja adaugata in zona de date */
+#define PAGE_PLACED	2
+
+static so_exec_t *exec;
+static uint8_t *state;
+static uint32_t *dir, *order;
+static uint32_t file_pages, data_pages;
+static int page_size;
+static char *page;
+static int fd;
+
+/* intoarce 1 daca pagina page din fisier contine doar zerouri */
+static int page_is_zero(uint32_t index)
+{
+	ssize_t ret;
+	int i;
+
+	memset(page, 0, page_size);
+	ret = pread(fd, page, page_size, (off_t)index * page_size);
+	DIE(ret < 0, "pread failed");
+
+	for (i = 0; i < page_size; i++)
+		if (page[i])
+			return 0;
+
+	return 1;
+}
+
+/* adauga pagina index din fisier in zona de date (o singura data) */
+static void place(uint32_t index)
+{
+	if (index >= file_pages || state[index] != PAGE_USED)
+		return;
+
+	state[index] = PAGE_PLACED;
+	if (page_is_zero(index))
+		return;
+
+	dir[index] = data_pages;
+	order[data_pages++] = index;
+}
+
+/*
+ * adauga paginile din fisier citite de loader pentru pagina de memorie
+ * page_index a segmentului (offset-ul segmentului poate sa nu fie aliniat)
+ */
+static void place_mem_page(so_seg_t *seg, uint32_t page_index)
+{
+	unsigned int start = page_index * page_size, len;
+
+	if (start >= seg->file_size)
+		return;
+
+	len = seg->file_size - start;
+	if (len > (unsigned int)page_size)
+		len = page_size;
+
+	place((seg->offset + start) / page_size);
+	place((seg->offset + start + len - 1) / page_size);
+}
+
+/* adauga paginile atinse in urma, in ordinea primului acces */
+static uint32_t place_trace(const char *path)
+{
+	struct trace_hdr hdr;
+	struct trace_entry entry;
+	uint64_t i;
+	so_seg_t *seg;
+	FILE *in;
+	int j;
+
+	in = fopen(path, "rb");
+	DIE(!in, "fopen failed");
+	DIE(fread(&hdr, sizeof(hdr), 1, in) != 1, "fread failed");
+	if (hdr.magic != TRACE_MAGIC || hdr.version != TRACE_VERSION ||
+	    hdr.hdr_size != sizeof(hdr)) {
+		fprintf(stderr, "%s: invalid trace\n", path);
+		exit(1);
+	}
+
+	for (i = 0; i < hdr.count; i++) {
+		DIE(fread(&entry, sizeof(entry), 1, in) != 1, "fread failed");
+
+		for (j = 0; j < exec->segments_no; j++) {
+			seg = &exec->segments[j];
+			if (entry.addr >= seg->vaddr &&
+			    entry.addr < seg->vaddr + seg->mem_size) {
+				place_mem_page(seg, (entry.addr - seg->vaddr)
+					       / page_size);
+				break;
+			}
+		}
+	}
+
+	fclose(in);
+
+	return data_pages;
+}
+
+static void write_all(FILE *out, const void *buf, size_t len)
+{
+	DIE(fwrite(buf, 1, len, out) != len, "fwrite failed");
+}
+
+int main(int argc, char *argv[])
+{
+	struct packed_hdr hdr;
+	struct packed_seg seg;
+	char out_path[4096];
+	struct stat st;
+	uint32_t hot_pages = 0, i;
+	uint64_t offset;
+	unsigned int start;
+	ssize_t ret;
+	FILE *out;
+	int j;
+
+	if (argc < 3) {
+		fprintf(stderr, "Usage: %s <executable> <trace|-> [image]\n",
+			argv[0]);
+		return 1;
+	}
+
+	exec = so_parse_exec(argv[1]);
+	if (!exec)
+		return 1;
+
+	fd = open(argv[1], O_RDONLY);
+	DIE(fd < 0, "open failed");
+	DIE(fstat(fd, &st) < 0, "fstat failed");
+
+	page_size = getpagesize();
+	page = malloc(page_size);
+	file_pages = (st.st_size + page_size - 1) / page_size;
+	state = calloc(file_pages, sizeof(*state));
+	dir = malloc(file_pages * sizeof(*dir));
+	order = malloc(file_pages * sizeof(*order));
+	DIE(!page || !state || !dir || !order, "malloc failed");
+
+	/* doar paginile cu date ale segmentelor sunt pastrate */
+	for (i = 0; i < file_pages; i++)
+		dir[i] = PACKED_NONE;
+	for (j = 0; j < exec->segments_no; j++) {
+		if (!exec->segments[j].file_size)
+			continue;
+		start = exec->segments[j].offset / page_size;
+		for (i = start; i <= (exec->segments[j].offset +
+		     exec->segments[j].file_size - 1) / page_size; i++)
+			state[i] = PAGE_USED;
+	}
+
+	/* paginile calde primele, apoi restul in ordinea din fisier */
+	if (strcmp(argv[2], "-"))
+		hot_pages = place_trace(argv[2]);
+	for (i = 0; i < file_pages; i++)
+		place(i);
+
+	if (argc > 3)
+		snprintf(out_path, sizeof(out_path), "%s", argv[3]);
+	else
+		snprintf(out_path, sizeof(out_path), "%s.packed", argv[1]);
+
+	out = fopen(out_path, "wb");
+	DIE(!out, "fopen failed");
+
+	offset = sizeof(hdr) + exec->segments_no * sizeof(seg) +
+		 file_pages * sizeof(*dir);
+
+	memset(&hdr, 0, sizeof(hdr));
+	hdr.magic = PACKED_MAGIC;
+	hdr.version = PACKED_VERSION;
+	hdr.hdr_size = sizeof(hdr);
+	hdr.page_size = page_size;
+	hdr.segments_no = exec->segments_no;
+	hdr.entry = exec->entry;
+	hdr.base_addr = exec->base_addr;
+	hdr.file_pages = file_pages;
+	hdr.data_pages = data_pages;
+	hdr.hot_pages = hot_pages;
+	hdr.data_offset = ALIGN_UP(offset, (uint64_t)page_size);
+	write_all(out, &hdr, sizeof(hdr));
+
+	for (j = 0; j < exec->segments_no; j++) {
+		memset(&seg, 0, sizeof(seg));
+		seg.vaddr = exec->segments[j].vaddr;
+		seg.file_size = exec->segments[j].file_size;
+		seg.mem_size = exec->segments[j].mem_size;
+		seg.offset = exec->segments[j].offset;
+		seg.perm = exec->segments[j].perm;
+		write_all(out, &seg, sizeof(seg));
+	}
+	write_all(out, dir, file_pages * sizeof(*dir));
+
+	memset(page, 0, page_size);
+	write_all(out, page, hdr.data_offset - offset);
+
+	for (i = 0; i < data_pages; i++) {
+		memset(page, 0, page_size);
+		ret = pread(fd, page, page_size, (off_t)order[i] * page_size);
+		DIE(ret < 0, "pread failed");
+		write_all(out, page, page_size);
+	}
+
+	DIE(fclose(out) != 0, "fclose failed");
+	close(fd);
+
+	printf("%s: %u pages (%u hot), %u pages skipped\n", out_path,
+	       data_pages, hot_pages, file_pages - data_pages);
+
+	return 0;
+}
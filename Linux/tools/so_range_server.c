@@ -0,0 +1,132 @@
+/*
+ * Local range server (stand-in for a remote artifact store)
+ *
+ * 2018, Operating Systems
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <fcntl.h>
+
+#include "range_proto.h"
+#include "utils.h"
+
+static char *file_data;
+static uint64_t file_size;
+
+/* intarzierea (in microsecunde) pentru fiecare 64KB trimisi */
+static long delay_us;
+
+static int send_all(int fd, const void *buf, size_t len)
+{
+	ssize_t ret;
+
+	while (len > 0) {
+		ret = send(fd, buf, len, MSG_NOSIGNAL);
+		if (ret < 0 && errno == EINTR)
+			continue;
+		if (ret <= 0)
+			return -1;
+		buf = (const char *)buf + ret;
+		len -= ret;
+	}
+
+	return 0;
+}
+
+static void *serve(void *arg)
+{
+	int fd = (intptr_t)arg;
+	struct range_req req;
+	uint64_t len;
+	ssize_t ret;
+
+	for (;;) {
+		ret = recv(fd, &req, sizeof(req), MSG_WAITALL);
+		if (ret != sizeof(req))
+			break;
+
+		if (req.len == 0) {
+			if (send_all(fd, &file_size, sizeof(file_size)) < 0)
+				break;
+			continue;
+		}
+
+		len = req.offset < file_size ? file_size - req.offset : 0;
+		if (len > req.len)
+			len = req.len;
+
+		/* simulam o retea lenta */
+		if (delay_us)
+			usleep(delay_us * ((len + 65535) / 65536));
+
+		if (len && send_all(fd, file_data + req.offset, len) < 0)
+			break;
+	}
+
+	close(fd);
+	return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+	struct sockaddr_un addr;
+	pthread_t thread;
+	struct stat st;
+	int opt, fd, sock, client;
+
+	while ((opt = getopt(argc, argv, "d:")) != -1) {
+		if (opt != 'd')
+			goto usage;
+		delay_us = atol(optarg);
+	}
+	if (argc - optind != 2)
+		goto usage;
+
+	fd = open(argv[optind + 1], O_RDONLY);
+	DIE(fd < 0, "open failed");
+	DIE(fstat(fd, &st) < 0, "fstat failed");
+	file_size = st.st_size;
+	file_data = mmap(NULL, file_size ? file_size : 1, PROT_READ,
+			 MAP_PRIVATE, fd, 0);
+	DIE(file_data == MAP_FAILED, "mmap failed");
+
+	sock = socket(AF_UNIX, SOCK_STREAM, 0);
+	DIE(sock < 0, "socket failed");
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	DIE(strlen(argv[optind]) >= sizeof(addr.sun_path), "socket path");
+	strcpy(addr.sun_path, argv[optind]);
+	unlink(argv[optind]);
+	DIE(bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0,
+	    "bind failed");
+	DIE(listen(sock, 16) < 0, "listen failed");
+
+	/* fiecare conexiune este servita de un thread separat */
+	for (;;) {
+		client = accept(sock, NULL, NULL);
+		if (client < 0) {
+			DIE(errno != EINTR, "accept failed");
+			continue;
+		}
+		DIE(pthread_create(&thread, NULL, serve,
+				   (void *)(intptr_t)client) != 0,
+		    "pthread_create failed");
+		pthread_detach(thread);
+	}
+
+	return 0;
+
+usage:
+	fprintf(stderr, "Usage: %s [-d delay_us] <socket> <file>\n", argv[0]);
+	return 1;
+}